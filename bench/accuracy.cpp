@@ -0,0 +1,317 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "../sphere.hpp"
+#include "../physics.hpp"
+
+/*
+ accuracy harness: runs each canonical scenario with every integrator and
+ timestep, measures drift/error against the analytic solution and the cost
+ per body-step, then prints a Pareto table per scenario.
+
+ usage: accuracy [--budget <max position error>]
+*/
+
+typedef void (*Integrator)(Sphere &, float);
+
+struct IntegratorEntry {
+	const char *name;
+	Integrator step;
+};
+
+const IntegratorEntry integrators[] = {
+	{"Euler", IntegrateEuler},
+	{"RK4", IntegrateRK4},
+	{"Verlet", IntegrateVerlet},
+};
+
+const float timesteps[] = {1.0f / 30.0f, 1.0f / 60.0f, 1.0f / 120.0f, 1.0f / 240.0f, 1.0f / 480.0f, 1.0f / 1000.0f};
+
+/* snapshot of every body, either simulated or analytic */
+struct State {
+	std::vector<glm::vec3> position;
+	std::vector<glm::vec3> velocity;
+	std::vector<float> mass;
+};
+
+struct Scenario {
+	const char *name;
+	int bodies;
+	float duration;
+	ForceModel force;
+	bool boundary;  // apply CheckBC
+	bool collide;   // apply SphereCollision between the two bodies
+	void (*analytic)(float t, State &state);        // exact solution at time t, also the initial condition
+	float (*potential)(const glm::vec3 &position, float mass);
+	glm::vec3 (*momentum)(const State &state);      // the momentum the scenario tracks, NULL if none is conserved
+};
+
+// ---------------------------------------------------------------- scenarios
+
+const float GM = 1.0f; // point mass at the origin for the orbit
+
+glm::vec3 pointMass(const glm::vec3 &position, float mass) {
+	float r = glm::length(position);
+	return -GM * mass * position / (r * r * r);
+}
+
+float noPotential(const glm::vec3 &position, float mass) {
+	return 0.0f;
+}
+
+float gravityPotential(const glm::vec3 &position, float mass) {
+	return mass * gravity * position.z;
+}
+
+float pointMassPotential(const glm::vec3 &position, float mass) {
+	return -GM * mass / glm::length(position);
+}
+
+glm::vec3 linearMomentum(const State &state) {
+	glm::vec3 p(0.0f, 0.0f, 0.0f);
+	for (size_t i = 0; i < state.mass.size(); i++) {
+		p += state.mass[i] * state.velocity[i];
+	}
+	return p;
+}
+
+glm::vec3 angularMomentum(const State &state) {
+	glm::vec3 l(0.0f, 0.0f, 0.0f);
+	for (size_t i = 0; i < state.mass.size(); i++) {
+		l += glm::cross(state.position[i], state.mass[i] * state.velocity[i]);
+	}
+	return l;
+}
+
+/* thrown from z=5 with no boundaries */
+void freeFall(float t, State &s) {
+	glm::vec3 x0(0.0f, 0.0f, 5.0f);
+	glm::vec3 v0(0.5f, 0.0f, 2.0f);
+	glm::vec3 g(0.0f, 0.0f, -gravity);
+	s.position.assign(1, x0 + v0 * t + 0.5f * g * t * t);
+	s.velocity.assign(1, v0 + g * t);
+	s.mass.assign(1, 1.0f);
+}
+
+/* dropped from rest at z=2, bouncing elastically on the z=0 plane (centre at z=R) */
+void bouncing(float t, State &s) {
+	float h = 2.0f - R;
+	float tFall = std::sqrt(2.0f * h / gravity);
+	float tau = std::fmod((double)t, 2.0 * tFall);
+	float fromTop = tau <= tFall ? tau : 2.0f * tFall - tau;
+	float vz = tau <= tFall ? -gravity * tau : gravity * (2.0f * tFall - tau);
+	s.position.assign(1, glm::vec3(0.0f, 0.0f, R + h - 0.5f * gravity * fromTop * fromTop));
+	s.velocity.assign(1, glm::vec3(0.0f, 0.0f, vz));
+	s.mass.assign(1, 1.0f);
+}
+
+/* two equal spheres head-on along x with no gravity, they swap velocities at contact */
+void headOn(float t, State &s) {
+	float speed = 1.0f;
+	float tContact = (2.0f - 2.0f * R) / (2.0f * speed);
+	s.position.resize(2);
+	s.velocity.resize(2);
+	s.mass.assign(2, 1.0f);
+	if (t < tContact) {
+		s.position[0] = glm::vec3(-1.0f + speed * t, 0.0f, 2.0f);
+		s.position[1] = glm::vec3(1.0f - speed * t, 0.0f, 2.0f);
+		s.velocity[0] = glm::vec3(speed, 0.0f, 0.0f);
+		s.velocity[1] = glm::vec3(-speed, 0.0f, 0.0f);
+	} else {
+		s.position[0] = glm::vec3(-R - speed * (t - tContact), 0.0f, 2.0f);
+		s.position[1] = glm::vec3(R + speed * (t - tContact), 0.0f, 2.0f);
+		s.velocity[0] = glm::vec3(-speed, 0.0f, 0.0f);
+		s.velocity[1] = glm::vec3(speed, 0.0f, 0.0f);
+	}
+}
+
+/* circular orbit of radius 1 around the point mass */
+void orbit(float t, State &s) {
+	float r = 1.0f;
+	float w = std::sqrt(GM / (r * r * r));
+	s.position.assign(1, glm::vec3(r * std::cos(w * t), r * std::sin(w * t), 0.0f));
+	s.velocity.assign(1, glm::vec3(-r * w * std::sin(w * t), r * w * std::cos(w * t), 0.0f));
+	s.mass.assign(1, 1.0f);
+}
+
+const Scenario scenarios[] = {
+	{"free fall", 1, 1.0f, uniformGravity, false, false, freeFall, gravityPotential, linearMomentum},
+	// the floor reverses p at every bounce, so there is nothing to compare against
+	{"bouncing", 1, 5.0f, uniformGravity, true, false, bouncing, gravityPotential, NULL},
+	{"head-on collision", 2, 1.0f, noForce, false, true, headOn, noPotential, linearMomentum},
+	{"orbit", 1, 4.0f * glm::pi<float>(), pointMass, false, false, orbit, pointMassPotential, angularMomentum},
+};
+
+// ---------------------------------------------------------------- runner
+
+struct Result {
+	const char *integrator;
+	float dt;
+	float energyDrift;    // max |E - E0| / |E0|
+	float momentumDrift;  // max |p - p_exact| / max |p_exact|, or / max sum m|v| when p_exact stays 0; NAN if not tracked
+	float positionError;  // max |x - x_exact| over bodies and steps
+	double nsPerBodyStep;
+	double usPerBodySecond; // cost of simulating one body for one second at this dt
+	bool pareto;
+};
+
+float energy(const Scenario &scenario, const State &s) {
+	float e = 0.0f;
+	for (size_t i = 0; i < s.mass.size(); i++) {
+		e += 0.5f * s.mass[i] * glm::dot(s.velocity[i], s.velocity[i]) + scenario.potential(s.position[i], s.mass[i]);
+	}
+	return e;
+}
+
+void reset(const Scenario &scenario, std::vector<Sphere> &spheres) {
+	State initial;
+	scenario.analytic(0.0f, initial);
+	spheres.resize(scenario.bodies);
+	for (int i = 0; i < scenario.bodies; i++) {
+		spheres[i].setMass(initial.mass[i]);
+		spheres[i].setPosition(initial.position[i]);
+		spheres[i].setVelocity(initial.velocity[i]);
+		updateAcceleration(spheres[i]);
+	}
+}
+
+void step(const Scenario &scenario, Integrator integrate, std::vector<Sphere> &spheres, float dt) {
+	for (Sphere &sphere : spheres) {
+		integrate(sphere, dt);
+		if (scenario.boundary) {
+			CheckBC(sphere);
+		}
+	}
+	if (scenario.collide) {
+		SphereCollision(spheres[0], spheres[1]);
+	}
+}
+
+Result run(const Scenario &scenario, const IntegratorEntry &integrator, float dt) {
+	Result result = {integrator.name, dt, 0.0f, 0.0f, 0.0f, 0.0, 0.0, false};
+	std::vector<Sphere> spheres;
+	int steps = (int)std::ceil(scenario.duration / dt);
+	setForceModel(scenario.force);
+
+	// accuracy pass, sampled every step
+	reset(scenario, spheres);
+	State exact, simulated;
+	scenario.analytic(0.0f, exact);
+	float e0 = energy(scenario, exact);
+	float pScale = 0.0f, pReference = 0.0f;
+	for (int n = 1; n <= steps; n++) {
+		step(scenario, integrator.step, spheres, dt);
+		scenario.analytic(n * dt, exact);
+		simulated = exact;
+		for (int i = 0; i < scenario.bodies; i++) {
+			simulated.position[i] = spheres[i].getPosition();
+			simulated.velocity[i] = spheres[i].getVelocity();
+			result.positionError = std::max(result.positionError, glm::distance(simulated.position[i], exact.position[i]));
+		}
+		result.energyDrift = std::max(result.energyDrift, std::fabs(energy(scenario, simulated) - e0) / std::fabs(e0));
+		if (scenario.momentum) {
+			result.momentumDrift = std::max(result.momentumDrift, glm::length(scenario.momentum(simulated) - scenario.momentum(exact)));
+			pScale = std::max(pScale, glm::length(scenario.momentum(exact)));
+		}
+		float sum = 0.0f;
+		for (int i = 0; i < scenario.bodies; i++) {
+			sum += exact.mass[i] * glm::length(exact.velocity[i]);
+		}
+		pReference = std::max(pReference, sum);
+	}
+	if (!scenario.momentum) {
+		result.momentumDrift = NAN;
+	} else {
+		// head-on: total momentum is exactly 0 throughout, scale by how much momentum is moving
+		result.momentumDrift /= pScale > 0.0f ? pScale : pReference;
+	}
+
+	// timing pass, nothing but stepping; repeat until it is long enough to trust
+	long long bodySteps = 0;
+	auto t_start = std::chrono::steady_clock::now();
+	auto t_now = t_start;
+	do {
+		reset(scenario, spheres);
+		for (int n = 0; n < steps; n++) {
+			step(scenario, integrator.step, spheres, dt);
+		}
+		bodySteps += (long long)steps * scenario.bodies;
+		t_now = std::chrono::steady_clock::now();
+	} while (t_now - t_start < std::chrono::milliseconds(50));
+	result.nsPerBodyStep = std::chrono::duration<double, std::nano>(t_now - t_start).count() / bodySteps;
+	result.usPerBodySecond = result.nsPerBodyStep / dt / 1000.0;
+
+	setForceModel(uniformGravity);
+	return result;
+}
+
+int main(int argc, char **argv) {
+	float budget = -1.0f;
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+			budget = std::atof(argv[++i]);
+		} else {
+			std::cerr << "usage: " << argv[0] << " [--budget <max position error>]" << std::endl;
+			return 1;
+		}
+	}
+
+	for (const Scenario &scenario : scenarios) {
+		std::vector<Result> results;
+		for (const IntegratorEntry &integrator : integrators) {
+			for (float dt : timesteps) {
+				results.push_back(run(scenario, integrator, dt));
+			}
+		}
+
+		// cheapest per simulated second first; a row is on the Pareto front if nothing cheaper is at least as accurate
+		std::sort(results.begin(), results.end(), [](const Result &a, const Result &b) {
+			return a.usPerBodySecond < b.usPerBodySecond;
+		});
+		float bestError = INFINITY;
+		for (Result &r : results) {
+			r.pareto = r.positionError < bestError;
+			bestError = std::min(bestError, r.positionError);
+		}
+
+		std::printf("\n## %s (%s)\n\n", scenario.name,
+			!scenario.momentum ? "no momentum drift, not conserved" :
+			scenario.momentum == angularMomentum ? "angular momentum drift" : "momentum drift");
+		std::printf("| integrator |     dt | ns/body-step | us/body-second | position error | energy drift | momentum drift | pareto |\n");
+		std::printf("|------------|--------|--------------|----------------|----------------|--------------|----------------|--------|\n");
+		for (const Result &r : results) {
+			char drift[32];
+			if (std::isnan(r.momentumDrift)) {
+				std::snprintf(drift, sizeof(drift), "n/a");
+			} else {
+				std::snprintf(drift, sizeof(drift), "%.3e", r.momentumDrift);
+			}
+			std::printf("| %-10s | 1/%-4.0f | %12.2f | %14.2f | %14.3e | %12.3e | %14s | %6s |\n",
+				r.integrator, 1.0f / r.dt, r.nsPerBodyStep, r.usPerBodySecond, r.positionError, r.energyDrift, drift,
+				r.pareto ? "*" : "");
+		}
+
+		if (budget >= 0.0f) {
+			const Result *pick = NULL;
+			for (const Result &r : results) {
+				if (r.positionError <= budget) {
+					pick = &r;
+					break;
+				}
+			}
+			if (pick) {
+				std::printf("\ncheapest within %g: %s at dt = 1/%.0f\n", budget, pick->integrator, 1.0f / pick->dt);
+			} else {
+				std::printf("\nnothing meets a position error of %g\n", budget);
+			}
+		}
+	}
+	return 0;
+}
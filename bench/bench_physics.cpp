@@ -0,0 +1,472 @@
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include <glm/glm.hpp>
+#include "../sphere.hpp"
+#include "../plane.hpp"
+#include "../physics.hpp"
+#include "../world.hpp"
+#include "../spatial.hpp"
+#include "../frame_arena.hpp"
+#include "../orientation.hpp"
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+/* every heap allocation in the process goes through here, so a benchmark can count them */
+static std::atomic<long> g_allocations(0);
+
+void *operator new(size_t size) {
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	void *p = std::malloc(size ? size : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+	std::free(p);
+}
+
+/* over-aligned (the arena's blocks): malloc'd with room to align, the original pointer kept just below */
+void *operator new(size_t size, std::align_val_t alignment) {
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	size_t align = (size_t)alignment;
+	char *raw = (char *)std::malloc(size + align + sizeof(void *));
+	if (!raw) {
+		throw std::bad_alloc();
+	}
+	char *p = (char *)(((uintptr_t)raw + sizeof(void *) + align - 1) & ~(uintptr_t)(align - 1));
+	((void **)p)[-1] = raw;
+	return p;
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+	if (p) {
+		std::free(((void **)p)[-1]);
+	}
+}
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept {
+	if (p) {
+		std::free(((void **)p)[-1]);
+	}
+}
+
+/* hidden window so the mesh benchmarks have a GL context to upload into */
+static GLFWwindow *g_window = NULL;
+/* same vertex decode as the app's shader, attribute 0 is the packed position, 1 the packed normal */
+static GLuint g_program = 0;
+static VertexLayout g_layout = {0, 1, -1, -1};
+
+/* n spheres scattered inside the 4x4 box, same seed every run so results compare */
+static std::vector<Sphere> makeSpheres(int n) {
+	std::vector<Sphere> spheres(n);
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> pos(-2.0f + R, 2.0f - R);
+	std::uniform_real_distribution<float> height(R, 4.0f);
+	std::uniform_real_distribution<float> vel(-1.0f, 1.0f);
+	for (int i = 0; i < n; i++) {
+		spheres[i].setMass(1.0f);
+		spheres[i].setPosition(glm::vec3(pos(rng), pos(rng), height(rng)));
+		spheres[i].setVelocity(glm::vec3(vel(rng), vel(rng), vel(rng)));
+		updateAcceleration(spheres[i]);
+	}
+	return spheres;
+}
+
+static Bodies makeBodies(int n) {
+	std::vector<Sphere> spheres = makeSpheres(n);
+	Bodies bodies;
+	for (const Sphere &sphere : spheres) {
+		bodies.add(sphere.getPosition(), sphere.getVelocity(), sphere.getMass());
+	}
+	return bodies;
+}
+
+static void BM_IntegrateEuler(benchmark::State &state) {
+	std::vector<Sphere> spheres = makeSpheres(state.range(0));
+	for (auto _ : state) {
+		for (Sphere &sphere : spheres) {
+			IntegrateEuler(sphere, 1.0f / 60.0f);
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_IntegrateEuler)->RangeMultiplier(8)->Range(2, 1 << 20);
+
+static void BM_IntegrateRK4(benchmark::State &state) {
+	std::vector<Sphere> spheres = makeSpheres(state.range(0));
+	for (auto _ : state) {
+		for (Sphere &sphere : spheres) {
+			IntegrateRK4(sphere, 1.0f / 60.0f);
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_IntegrateRK4)->RangeMultiplier(8)->Range(2, 1 << 20);
+
+static void BM_IntegrateVerlet(benchmark::State &state) {
+	std::vector<Sphere> spheres = makeSpheres(state.range(0));
+	for (auto _ : state) {
+		for (Sphere &sphere : spheres) {
+			IntegrateVerlet(sphere, 1.0f / 60.0f);
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_IntegrateVerlet)->RangeMultiplier(8)->Range(2, 1 << 20);
+
+static void BM_CheckBC(benchmark::State &state) {
+	std::vector<Sphere> spheres = makeSpheres(state.range(0));
+	for (auto _ : state) {
+		for (Sphere &sphere : spheres) {
+			CheckBC(sphere);
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CheckBC)->RangeMultiplier(8)->Range(2, 1 << 20);
+
+/* narrow phase only: every body is paired with its neighbour and the pairs are in contact */
+static void BM_SphereCollision(benchmark::State &state) {
+	std::vector<Sphere> spheres = makeSpheres(state.range(0));
+	// overlapping and closing in, so every pair goes through the resolve path
+	std::vector<glm::vec3> approach(spheres.size());
+	for (int i = 0; i + 1 < (int)spheres.size(); i += 2) {
+		spheres[i + 1].setPosition(spheres[i].getPosition() + glm::vec3(1.5f * R, 0.0f, 0.0f));
+		approach[i] = spheres[i].getVelocity() + glm::vec3(1.0f, 0.0f, 0.0f);
+		approach[i + 1] = spheres[i].getVelocity() - glm::vec3(1.0f, 0.0f, 0.0f);
+	}
+	for (auto _ : state) {
+		for (int i = 0; i + 1 < (int)spheres.size(); i += 2) {
+			// the last iteration left them separating, which SphereCollision rejects early
+			spheres[i].setVelocity(approach[i]);
+			spheres[i + 1].setVelocity(approach[i + 1]);
+			SphereCollision(spheres[i], spheres[i + 1]);
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * (state.range(0) / 2));
+}
+BENCHMARK(BM_SphereCollision)->RangeMultiplier(8)->Range(2, 1 << 20);
+
+/* reference: test every pair. O(n^2), so capped well below 1M */
+static void BM_BroadPhaseAllPairs(benchmark::State &state) {
+	std::vector<Sphere> spheres = makeSpheres(state.range(0));
+	for (auto _ : state) {
+		for (int i = 0; i < (int)spheres.size(); i++) {
+			for (int j = i + 1; j < (int)spheres.size(); j++) {
+				SphereCollision(spheres[i], spheres[j]);
+			}
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BroadPhaseAllPairs)->RangeMultiplier(8)->Range(2, 1 << 12);
+
+/* integrate + CheckBC for every body: out-of-line function per body vs the fused World stepper */
+typedef void (*Integrator)(Sphere &, float);
+static const Integrator integrators[NUM_INTEGRATORS] = {IntegrateEuler, IntegrateRK4, IntegrateVerlet};
+
+static void StepArgs(benchmark::internal::Benchmark *b) {
+	b->ArgNames({"integrator", "bodies"});
+	for (int integrator = 0; integrator < NUM_INTEGRATORS; integrator++) {
+		for (int n = 2; n < 1 << 20; n *= 8) {
+			b->Args({integrator, n});
+		}
+		b->Args({integrator, 1 << 20});
+	}
+}
+
+static void BM_StepFunctionPerBody(benchmark::State &state) {
+	Integrator integrate = integrators[state.range(0)];
+	std::vector<Sphere> spheres = makeSpheres(state.range(1));
+	for (auto _ : state) {
+		for (Sphere &sphere : spheres) {
+			integrate(sphere, 1.0f / 60.0f);
+			CheckBC(sphere);
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_StepFunctionPerBody)->Apply(StepArgs);
+
+static void BM_StepWorld(benchmark::State &state) {
+	Stepper stepper = selectStepper((IntegratorKind)state.range(0), FORCE_GRAVITY, BOUNDARY_BOX);
+	Bodies bodies = makeBodies(state.range(1));
+	stepper.prime(bodies);
+	for (auto _ : state) {
+		stepper.step(bodies, 1.0f / 60.0f);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_StepWorld)->Apply(StepArgs);
+
+/* n bodies at constant density in a cube that grows with n, shuffled so memory order has
+   nothing to do with position, like bodies that have been moving around for a while */
+static Bodies makeSpread(int n) {
+	Bodies bodies;
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> pos(0.0f, 2.0f * std::cbrt((float)n));
+	std::uniform_real_distribution<float> vel(-1.0f, 1.0f);
+	for (int i = 0; i < n; i++) {
+		bodies.add(glm::vec3(pos(rng), pos(rng), pos(rng)), glm::vec3(vel(rng), vel(rng), vel(rng)), 1.0f);
+	}
+	return bodies;
+}
+
+static void BM_BroadPhaseGrid(benchmark::State &state) {
+	Bodies bodies = makeSpread(state.range(0));
+	BroadPhase broad_phase;
+	size_t pairs = 0;
+	for (auto _ : state) {
+		pairs = broad_phase.findPairs(bodies).size();
+		FrameArena::resetAll();
+	}
+	state.counters["pairs"] = pairs;
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BroadPhaseGrid)->RangeMultiplier(8)->Range(2, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+static void BM_MortonReorder(benchmark::State &state) {
+	Bodies bodies = makeSpread(state.range(0));
+	BodyReorder body_reorder;
+	for (auto _ : state) {
+		body_reorder.reorder(bodies);
+		FrameArena::resetAll();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MortonReorder)->RangeMultiplier(8)->Range(2, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+/* full step (integrate + collide) with and without the periodic Morton reorder.
+   Run with --benchmark_perf_counters=CACHE-MISSES for the cache-miss delta. */
+static void BM_StepWithCollision(benchmark::State &state) {
+	bool reorder = state.range(0);
+	Bodies bodies = makeSpread(state.range(1));
+	Stepper stepper = selectStepper(INTEGRATOR_VERLET, FORCE_NONE, BOUNDARY_NONE);
+	stepper.prime(bodies);
+	BroadPhase broad_phase;
+	BodyReorder body_reorder;
+	if (reorder) {
+		body_reorder.reorder(bodies);
+	}
+	for (auto _ : state) {
+		stepper.step(bodies, 1.0f / 60.0f);
+		if (reorder) {
+			body_reorder.update(bodies);
+		}
+		broad_phase.collide(bodies);
+		FrameArena::resetAll();
+		benchmark::ClobberMemory();
+	}
+	state.counters["interval"] = reorder ? body_reorder.getInterval() : 0;
+	state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_StepWithCollision)
+	->ArgNames({"reorder", "bodies"})
+	->ArgsProduct({{0, 1}, {1 << 10, 1 << 14, 1 << 17, 1 << 20}})
+	->Unit(benchmark::kMillisecond);
+
+/* steady state must not touch the heap: after warm-up steps (arena grown, worker pool
+   started, a reorder done) a full step with reorder + broad phase is run and every
+   operator new counted. Fails the benchmark if there is even one. */
+static void BM_StepAllocations(benchmark::State &state) {
+	Bodies bodies = makeSpread(state.range(0));
+	Stepper stepper = selectStepper(INTEGRATOR_VERLET, FORCE_NONE, BOUNDARY_NONE);
+	stepper.prime(bodies);
+	BroadPhase broad_phase;
+	BodyReorder body_reorder;
+	for (int step = 0; step < 2 * 512; step++) {
+		stepper.step(bodies, 1.0f / 60.0f);
+		if (step % 64 == 0) {
+			body_reorder.reorder(bodies);
+		}
+		broad_phase.collide(bodies);
+		FrameArena::resetAll();
+	}
+
+	long before = g_allocations.load();
+	for (auto _ : state) {
+		stepper.step(bodies, 1.0f / 60.0f);
+		body_reorder.reorder(bodies);
+		broad_phase.collide(bodies);
+		FrameArena::resetAll();
+	}
+	long allocations = g_allocations.load() - before;
+	state.counters["allocs_per_step"] = (double)allocations / state.iterations();
+	state.counters["arena_KB"] = FrameArena::totalHighWater() / 1024.0;
+	if (allocations > 0) {
+		state.SkipWithError("heap allocations in steady-state steps");
+	}
+}
+BENCHMARK(BM_StepAllocations)->Arg(1 << 10)->Arg(1 << 17)->Iterations(64)->Unit(benchmark::kMillisecond);
+
+static Bodies makeSpinning(int n) {
+	Bodies bodies = makeSpread(n);
+	std::mt19937 rng(99);
+	std::uniform_real_distribution<float> spin(-6.0f, 6.0f);
+	for (int i = 0; i < n; i++) {
+		bodies.angularVelocity[i] = glm::vec3(spin(rng), spin(rng), spin(rng));
+	}
+	return bodies;
+}
+
+// the old way: one quaternion step and one translate * mat4_cast per body
+static void BM_TransformsPerBody(benchmark::State &state) {
+	Bodies bodies = makeSpinning(state.range(0));
+	std::vector<glm::mat4> models(bodies.size());
+	for (auto _ : state) {
+		for (int i = 0; i < bodies.size(); i++) {
+			glm::quat &q = bodies.orientation[i];
+			const glm::vec3 &w = bodies.angularVelocity[i];
+			q = glm::normalize(q + (0.5f / 60.0f) * (glm::quat(0.0f, w.x, w.y, w.z) * q));
+			models[i] = glm::translate(glm::mat4(1.0f), bodies.position[i]) * glm::mat4_cast(q);
+		}
+		benchmark::DoNotOptimize(models.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TransformsPerBody)->RangeMultiplier(8)->Range(8, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+// the batch passes: orientation step (as in World::step), then packed 3x4 rows as into the instance buffer
+static void BM_TransformsBatch(benchmark::State &state) {
+	Bodies bodies = makeSpinning(state.range(0));
+	std::vector<float> transforms(bodies.size() * transformFloats);
+	for (auto _ : state) {
+		integrateOrientations(bodies, 1.0f / 60.0f);
+		packTransforms(bodies, transforms.data());
+		benchmark::DoNotOptimize(transforms.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TransformsBatch)->RangeMultiplier(8)->Range(8, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+static void BM_SphereInit(benchmark::State &state) {
+	if (!g_window) {
+		state.SkipWithError("no GL context");
+		return;
+	}
+	Sphere sphere;
+	for (auto _ : state) {
+		sphere.init(g_layout, R);
+		sphere.cleanup();
+		FrameArena::resetAll();
+	}
+}
+BENCHMARK(BM_SphereInit)->Unit(benchmark::kMillisecond);
+
+static void BM_PlaneInit(benchmark::State &state) {
+	if (!g_window) {
+		state.SkipWithError("no GL context");
+		return;
+	}
+	Plane plane;
+	for (auto _ : state) {
+		plane.init(g_layout, 0.0f);
+		plane.cleanup();
+		FrameArena::resetAll();
+	}
+}
+BENCHMARK(BM_PlaneInit)->Unit(benchmark::kMillisecond);
+
+/* submit the sphere state.range(0) times and wait for the GPU, so vertex fetch shows up */
+static void BM_SphereDraw(benchmark::State &state) {
+	if (!g_window || !g_program) {
+		state.SkipWithError("no GL context");
+		return;
+	}
+	Sphere sphere;
+	sphere.init(g_layout, R);
+	glUseProgram(g_program);
+	for (auto _ : state) {
+		for (int i = 0; i < state.range(0); i++) {
+			sphere.draw();
+		}
+		glFinish();
+	}
+	sphere.cleanup();
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SphereDraw)->RangeMultiplier(8)->Range(1, 4096)->Unit(benchmark::kMicrosecond);
+
+static GLuint buildProgram() {
+	const char *vertex_shader = "#version 330\n"
+		"layout(location = 0) in vec3 vp;"
+		"layout(location = 1) in vec2 vn;"
+		"uniform vec3 pos_scale;"
+		"uniform vec3 pos_offset;"
+		"out vec2 normal;"
+		"void main() { normal = vn; gl_Position = vec4( (pos_offset + pos_scale * vp) * 0.25, 1.0 ); }";
+	const char *fragment_shader = "#version 330\n"
+		"in vec2 normal;"
+		"out vec4 frag_colour;"
+		"void main() { frag_colour = vec4( 0.5 + 0.25 * normal, 0.5, 1.0 ); }";
+	GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(vs, 1, &vertex_shader, NULL);
+	glCompileShader(vs);
+	GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(fs, 1, &fragment_shader, NULL);
+	glCompileShader(fs);
+	GLuint program = glCreateProgram();
+	glAttachShader(program, vs);
+	glAttachShader(program, fs);
+	glBindAttribLocation(program, 0, "vp");
+	glBindAttribLocation(program, 1, "vn");
+	glLinkProgram(program);
+	glDeleteShader(vs);
+	glDeleteShader(fs);
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+int main(int argc, char **argv) {
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+
+	if (glfwInit()) {
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		g_window = glfwCreateWindow(64, 64, "bench", NULL, NULL);
+		if (g_window) {
+			glfwMakeContextCurrent(g_window);
+			glewExperimental = GL_TRUE;
+			glewInit();
+			g_program = buildProgram();
+			g_layout.posScale = glGetUniformLocation(g_program, "pos_scale");
+			g_layout.posOffset = glGetUniformLocation(g_program, "pos_offset");
+		}
+	}
+
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	glfwTerminate();
+	return 0;
+}
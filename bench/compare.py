@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Compare two bench_physics JSON results and flag regressions.
+
+usage: compare.py baseline.json current.json [--threshold 0.10] [--metric real_time]
+
+Exits with status 1 if any benchmark got slower than the threshold allows.
+"""
+import argparse
+import json
+import sys
+
+
+def load(path, metric):
+    with open(path) as f:
+        data = json.load(f)
+    # with --benchmark_repetitions compare the medians only, otherwise the single runs
+    repeated = any(b.get("run_type") == "aggregate" for b in data["benchmarks"])
+    results = {}
+    for b in data["benchmarks"]:
+        if repeated:
+            if b.get("run_type") != "aggregate" or b.get("aggregate_name") != "median":
+                continue
+        elif b.get("run_type", "iteration") != "iteration":
+            continue
+        if b.get("error_occurred") or b.get("skipped"):
+            continue
+        results[b.get("run_name", b["name"])] = b[metric]
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="allowed slowdown as a fraction (default 0.10 = 10%%)")
+    parser.add_argument("--metric", default="real_time",
+                        help="json field to compare (real_time, cpu_time, ...)")
+    args = parser.parse_args()
+
+    base = load(args.baseline, args.metric)
+    curr = load(args.current, args.metric)
+
+    regressions = 0
+    print("%-40s %14s %14s %9s" % ("benchmark", "baseline", "current", "change"))
+    for name in sorted(base):
+        if name not in curr:
+            print("%-40s %14.1f %14s %9s" % (name, base[name], "-", "missing"))
+            continue
+        change = (curr[name] - base[name]) / base[name] if base[name] else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("%-40s %14.1f %14.1f %+8.1f%%%s" % (name, base[name], curr[name], change * 100, flag))
+    for name in sorted(set(curr) - set(base)):
+        print("%-40s %14s %14.1f %9s" % (name, "-", curr[name], "new"))
+
+    if regressions:
+        print("\n%d benchmark(s) regressed by more than %.0f%%" % (regressions, args.threshold * 100))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,138 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <glm/glm.hpp>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "../world.hpp"
+#include "../sim_feed.hpp"
+
+/*
+ feed latency: forks a producer process that steps N bodies and publishes every step into the
+ shared-memory feed at a fixed rate, while this process reads the newest frame as soon as it
+ shows up. Latency is reader clock minus the stamp the writer put in the frame (both steady
+ clock, so they compare across processes).
+
+ usage: feed_latency [--bodies N] [--steps N] [--rate Hz]
+*/
+
+const char *feedName = "glfw2lunar_feed_latency";
+
+static void produce(int bodyCount, int steps, double rate) {
+	Bodies bodies;
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> pos(-2.0f + R, 2.0f - R);
+	std::uniform_real_distribution<float> height(R, 4.0f);
+	for (int i = 0; i < bodyCount; i++) {
+		bodies.add(glm::vec3(pos(rng), pos(rng), height(rng)), glm::vec3(0.0f), 1.0f);
+	}
+	World<Verlet, UniformGravity, BoxBoundary>::prime(bodies);
+
+	SimFeedWriter feed;
+	if (!feed.open(feedName, bodyCount)) {
+		exit(1);
+	}
+	// give the reader time to attach before the first step
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+	const int64_t period = (int64_t)(1e9 / rate);
+	int64_t next = feedClockNs();
+	for (int step = 0; step < steps; step++) {
+		World<Verlet, UniformGravity, BoxBoundary>::step(bodies, 1.0f / 60.0f);
+		feed.publish(bodies, step / 60.0);
+		next += period;
+		while (feedClockNs() < next) {
+			// spin, sleeping would put the scheduler's wakeup jitter into the producer
+		}
+	}
+	// keep the object around until the reader has seen the last step
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	feed.close();
+}
+
+static double percentile(std::vector<int64_t> &values, double p) {
+	size_t index = std::min(values.size() - 1, (size_t)(p * values.size()));
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index] / 1000.0;
+}
+
+int main(int argc, char **argv) {
+	int bodyCount = 1000;
+	int steps = 10000;
+	double rate = 1000.0;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--bodies") == 0 && i + 1 < argc) {
+			bodyCount = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+			steps = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+			rate = atof(argv[++i]);
+		} else {
+			std::cout << "usage: " << argv[0] << " [--bodies N] [--steps N] [--rate Hz]" << std::endl;
+			return 1;
+		}
+	}
+
+	pid_t producer = fork();
+	if (producer == 0) {
+		produce(bodyCount, steps, rate);
+		_exit(0);
+	}
+
+	SimFeedReader feed;
+	while (!feed.open(feedName)) {
+		if (waitpid(producer, NULL, WNOHANG) == producer) {
+			std::cout << "producer exited before the feed appeared" << std::endl;
+			return 1;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	// spin on the published counter, copy each new frame out and stamp it
+	std::vector<int64_t> latencies;
+	latencies.reserve(steps);
+	FeedSnapshot snapshot;
+	uint64_t seen = 0;
+	int missed = 0, retried = 0;
+	while (seen < (uint64_t)steps) {
+		uint64_t published = feed.published();
+		if (published == seen) {
+			if (waitpid(producer, NULL, WNOHANG) == producer) {
+				break;
+			}
+			std::this_thread::yield();  // lets the producer run when both share a core
+			continue;
+		}
+		int retries = 0;
+		if (!feed.readLatest(snapshot, &retries)) {
+			continue;
+		}
+		int64_t now = feedClockNs();
+		missed += (int)(snapshot.step - seen);  // steps overwritten before we got to them
+		seen = snapshot.step + 1;
+		retried += retries;
+		latencies.push_back(now - snapshot.publishedNs);
+	}
+	waitpid(producer, NULL, 0);
+
+	if (latencies.empty()) {
+		std::cout << "no frames received" << std::endl;
+		return 1;
+	}
+	size_t received = latencies.size();
+	double p50 = percentile(latencies, 0.50);
+	double p99 = percentile(latencies, 0.99);
+	double p999 = percentile(latencies, 0.999);
+	double worst = *std::max_element(latencies.begin(), latencies.end()) / 1000.0;
+	printf("%d bodies (%zu bytes/frame) at %.0f Hz: %zu frames read, %d missed, %d seqlock retries\n",
+		bodyCount, bodyCount * sizeof(FeedBody), rate, received, missed, retried);
+	printf("step latency us: p50 %.2f  p99 %.2f  p99.9 %.2f  max %.2f\n", p50, p99, p999, worst);
+	return 0;
+}
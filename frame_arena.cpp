@@ -0,0 +1,103 @@
+#include "frame_arena.hpp"
+
+#include <cstdlib>
+#include <cstdint>
+#include <mutex>
+#include <memory>
+#include <new>
+#include <algorithm>
+
+// arenas are owned here so resetAll() and the statistics can reach every thread's
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<FrameArena>> registry;
+
+static const size_t blockAlignment = 64;
+
+static char *allocateBlock(size_t bytes, size_t alignment = blockAlignment)
+{
+    return (char *)::operator new(bytes, std::align_val_t(alignment));
+}
+
+static void freeBlock(char *block, size_t alignment = blockAlignment)
+{
+    ::operator delete(block, std::align_val_t(alignment));
+}
+
+FrameArena::FrameArena(size_t blockBytes)
+{
+    capacity = blockBytes;
+    block = allocateBlock(capacity);
+    used = 0;
+    spilled = 0;
+    highWater = 0;
+}
+
+FrameArena::~FrameArena()
+{
+    reset();
+    freeBlock(block);
+}
+
+void *FrameArena::allocate(size_t bytes, size_t alignment)
+{
+    // aligned on the address, not the offset, so alignments above the block's also hold
+    uintptr_t base = (uintptr_t)block;
+    size_t start = ((base + used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+    if (start + bytes <= capacity) {
+        used = start + bytes;
+        highWater = std::max(highWater, used + spilled);
+        return block + start;
+    }
+    // doesn't fit: a block of its own for now, folded into the main block at reset
+    size_t extraAlignment = std::max(alignment, blockAlignment);
+    char *extra = allocateBlock(std::max(bytes, blockAlignment), extraAlignment);
+    overflow.push_back(std::make_pair(extra, extraAlignment));
+    spilled += bytes + alignment;
+    highWater = std::max(highWater, used + spilled);
+    return extra;
+}
+
+void FrameArena::reset()
+{
+    if (!overflow.empty()) {
+        for (const std::pair<char *, size_t> &extra : overflow) {
+            freeBlock(extra.first, extra.second);
+        }
+        overflow.clear();
+        // grow to the high-water mark with some headroom so the next step fits in one block
+        freeBlock(block);
+        capacity = highWater + highWater / 4;
+        block = allocateBlock(capacity);
+    }
+    used = 0;
+    spilled = 0;
+}
+
+FrameArena &FrameArena::local()
+{
+    thread_local FrameArena *arena = NULL;
+    if (!arena) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.emplace_back(new FrameArena());
+        arena = registry.back().get();
+    }
+    return *arena;
+}
+
+void FrameArena::resetAll()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (std::unique_ptr<FrameArena> &arena : registry) {
+        arena->reset();
+    }
+}
+
+size_t FrameArena::totalHighWater()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    size_t total = 0;
+    for (std::unique_ptr<FrameArena> &arena : registry) {
+        total += arena->getHighWater();
+    }
+    return total;
+}
@@ -0,0 +1,81 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstddef>
+#include <vector>
+#include <type_traits>
+#include <utility>
+
+/*
+ linear allocator for data that only lives until the end of the current step or frame:
+ allocation is a pointer bump, nothing is freed individually, and resetAll() at the end of the
+ frame drops everything at once. Every thread gets its own arena from local(), so workers
+ never contend. An arena that overflows its block during a step gets one block sized to the
+ high-water mark at the next reset, after which steps stop touching the heap.
+
+     ArenaVector<int> order(ArenaAllocator<int>(FrameArena::local()));
+     ...
+     FrameArena::resetAll();     // once per frame, while no worker is running
+*/
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t blockBytes = 1 << 20);
+    ~FrameArena();
+    void *allocate(size_t bytes, size_t alignment);
+    void reset();
+
+    size_t getUsed() const { return used + spilled; }
+    size_t getHighWater() const { return highWater; }
+    size_t getCapacity() const { return capacity; }
+
+    static FrameArena &local();     // the calling thread's arena
+    static void resetAll();
+    static size_t totalHighWater(); // summed over every thread's arena
+
+private:
+    char *block;
+    size_t capacity, used;
+    std::vector<std::pair<char *, size_t>> overflow;   // blocks (and their alignment) taken after the main one filled up this step
+    size_t spilled, highWater;
+
+    FrameArena(const FrameArena &);
+    FrameArena &operator=(const FrameArena &);
+};
+
+// std allocator on top of a FrameArena; deallocate does nothing, the memory goes at reset
+template <class T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+
+    explicit ArenaAllocator(FrameArena &arena) : arena(&arena) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t n) { return (T *)arena->allocate(n * sizeof(T), alignof(T)); }
+    void deallocate(T *, size_t) {}
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U> &other) const { return arena != other.arena; }
+
+    FrameArena *arena;
+};
+
+// a vector whose storage is only valid until the next FrameArena::resetAll()
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+template <class T>
+ArenaVector<T> arenaVector(size_t reserve = 0)
+{
+    ArenaVector<T> vector((ArenaAllocator<T>(FrameArena::local())));
+    vector.reserve(reserve);
+    return vector;
+}
+
+#endif // FRAME_ARENA_H
@@ -0,0 +1,59 @@
+#include "frame_stats.hpp"
+
+FrameStats::FrameStats()
+{
+    targetMs = 1000.0f / 60.0f;
+    reset();
+}
+
+void FrameStats::setTargetInterval(float seconds)
+{
+    targetMs = seconds * 1000.0f;
+}
+
+void FrameStats::add(float frameSeconds)
+{
+    float ms = frameSeconds * 1000.0f;
+    int bin = (int)(ms / binMs);
+    if (bin < 0) {
+        bin = 0;
+    }
+    if (bin > numBins) {
+        bin = numBins;
+    }
+    bins[bin]++;
+    frames++;
+    if (ms > 1.5f * targetMs) {
+        dropped++;
+    }
+    if (ms > worstMs) {
+        worstMs = ms;
+    }
+}
+
+float FrameStats::percentileMs(float p) const
+{
+    if (frames == 0) {
+        return 0.0f;
+    }
+    int rank = (int)(p * (frames - 1)) + 1;
+    int seen = 0;
+    for (int bin = 0; bin < numBins; bin++) {
+        seen += bins[bin];
+        if (seen >= rank) {
+            float upper = (bin + 1) * binMs;  // upper edge of the bin
+            return upper < worstMs ? upper : worstMs;
+        }
+    }
+    return worstMs;
+}
+
+void FrameStats::reset()
+{
+    for (int bin = 0; bin <= numBins; bin++) {
+        bins[bin] = 0;
+    }
+    frames = 0;
+    dropped = 0;
+    worstMs = 0.0f;
+}
@@ -0,0 +1,27 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+// frame-time histogram over a reporting window: fixed 0.1 ms bins, so adding a frame
+// never allocates, and percentiles are read straight off the cumulative counts
+class FrameStats
+{
+public:
+    FrameStats();
+    void setTargetInterval(float seconds);  // frames longer than 1.5x this count as dropped
+    void add(float frameSeconds);
+    float percentileMs(float p) const;      // p in [0, 1]
+    float maxMs() const { return worstMs; }
+    int getFrames() const { return frames; }
+    int getDropped() const { return dropped; }
+    void reset();
+
+private:
+    static const int numBins = 1000;        // 0 .. 100 ms
+    static constexpr float binMs = 0.1f;
+    int bins[numBins + 1];                  // last bin catches everything slower
+    int frames, dropped;
+    float worstMs;
+    float targetMs;
+};
+
+#endif // FRAME_STATS_H
@@ -0,0 +1,115 @@
+#include "frame_writer.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <filesystem>
+
+FrameWriter::FrameWriter()
+{
+    width = 0;
+    height = 0;
+    nextNumber = 0;
+    running = false;
+}
+
+FrameWriter::~FrameWriter()
+{
+    stop();
+}
+
+bool FrameWriter::start(const std::string &directory, int width, int height)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cout << "can't create " << directory << ": " << error.message() << std::endl;
+        return false;
+    }
+    this->directory = directory;
+    this->width = width;
+    this->height = height;
+    nextNumber = 0;
+    running = true;
+    worker = std::thread(&FrameWriter::run, this);
+    return true;
+}
+
+void FrameWriter::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+    }
+    changed.notify_all();
+    worker.join();
+}
+
+void FrameWriter::push(const unsigned char *rgba)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return (int)queue.size() < maxQueued || !running; });
+    if (!running) {
+        return;
+    }
+
+    Frame frame;
+    frame.number = nextNumber++;
+    if (!spare.empty()) {
+        frame.pixels.swap(spare.back());
+        spare.pop_back();
+    }
+    frame.pixels.assign(rgba, rgba + width * height * 4);
+    queue.push_back(std::move(frame));
+    lock.unlock();
+    changed.notify_all();
+}
+
+void FrameWriter::run()
+{
+    std::vector<unsigned char> row(width * 3);
+    for (;;) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return !queue.empty() || !running; });
+            if (queue.empty()) {
+                return;     // stopped and drained
+            }
+            frame = std::move(queue.front());
+            queue.erase(queue.begin());
+        }
+        changed.notify_all();
+
+        write(frame, row);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        spare.push_back(std::move(frame.pixels));
+    }
+}
+
+void FrameWriter::write(const Frame &frame, std::vector<unsigned char> &row)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "/frame_%05d.ppm", frame.number);
+    std::string path = directory + name;
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cout << "can't write " << path << std::endl;
+        return;
+    }
+    std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+    // GL rows start at the bottom, PPM rows at the top; drop alpha on the way
+    for (int y = height - 1; y >= 0; y--) {
+        const unsigned char *src = &frame.pixels[y * width * 4];
+        for (int x = 0; x < width; x++) {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        std::fwrite(&row[0], 1, row.size(), file);
+    }
+    std::fclose(file);
+}
@@ -0,0 +1,41 @@
+#ifndef FRAME_WRITER_H
+#define FRAME_WRITER_H
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// writes RGBA frames read back from GL as a numbered PPM sequence on a worker thread
+// (frame_00000.ppm, ...). ffmpeg -i frame_%05d.ppm turns it into a video.
+class FrameWriter
+{
+public:
+    FrameWriter();
+    ~FrameWriter();
+    bool start(const std::string &directory, int width, int height);
+    void stop();                                // writes out everything queued, then joins
+    void push(const unsigned char *rgba);       // copies the frame, blocks if the queue is full
+
+private:
+    static const int maxQueued = 8;
+    struct Frame {
+        int number;
+        std::vector<unsigned char> pixels;
+    };
+
+    std::string directory;
+    int width, height, nextNumber;
+    bool running;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<Frame> queue;
+    std::vector<std::vector<unsigned char>> spare; // recycled pixel buffers
+
+    void run();
+    void write(const Frame &frame, std::vector<unsigned char> &row);
+};
+
+#endif // FRAME_WRITER_H
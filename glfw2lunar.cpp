@@ -4,17 +4,33 @@
 #include <fstream>
 #include <chrono>
 #include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "sphere.hpp"
+#include "instances.hpp"
+#include "orientation.hpp"
 #include "plane.hpp"
 #include "line.hpp"
+#include "physics.hpp"
+#include "world.hpp"
+#include "spatial.hpp"
+#include "profiler.hpp"
+#include "gpu_timer.hpp"
+#include "frame_stats.hpp"
+#include "offscreen.hpp"
+#include "frame_writer.hpp"
+#include "sim_feed.hpp"
+#include "shader_cache.hpp"
+#include "frame_arena.hpp"
 
 #define GL_LOG_FILE "gl.log"
 
-const float gravity = 9.80665f;;
-const float R = 0.5f;
+// render passes timed on the GPU
+enum { PASS_PLANE, PASS_SPHERES, NUM_PASSES };
 
 std::ofstream log_file;
 
@@ -58,218 +74,67 @@ void glfw_framebuffer_size_callback( GLFWwindow *window, int width, int height )
 	/* update any perspective matrices used here */
 }
 
-void updateAcceleration (Sphere &sphere){
-	glm::vec3 totalForce;
-
-	totalForce.x = 0.0f;
-	totalForce.y = 0.0f;
-	totalForce.z = -sphere.getMass()*gravity;
-	sphere.setAcceleration(totalForce/(sphere.getMass()));
-}
-
-void IntegrateEuler(Sphere &sphere, float DT){
-		sphere.setVelocity(sphere.getAcceleration()*DT + sphere.getVelocity());
-		sphere.setPosition(sphere.getVelocity()*DT + sphere.getPosition());
-		updateAcceleration(sphere);
-}
-
-void IntegrateRK4(Sphere &bola, float DT)
-{
-	glm::vec3 Pos;
-	glm::vec3 Vel;
-
-	glm::vec3 Kv1,Kv2,Kv3,Kv4; //Son aceleraciones
-	glm::vec3 Kx1,Kx2,Kx3,Kx4; //Son velocidades
-	glm::vec3 xK2,xK3,xK4; //Son las posiciones estimadas para evaluar la aceleracion
-
-	Kv1 = bola.getAcceleration();
-	Kx1 = bola.getVelocity();
-
-	xK2 = bola.getPosition() + Kx1*DT/2.0f;
-	updateAcceleration(bola);
-	Kv2 = bola.getAcceleration();
-	Kx2 = bola.getVelocity() + Kv1 * DT/2.0f;
-
-	xK3 = bola.getPosition() + Kx2*DT/2.0f;
-	updateAcceleration(bola);
-	Kv3 = bola.getAcceleration();
-	Kx3 = bola.getVelocity() + Kv2 * DT/2.0f;
-
-	xK4 = bola.getPosition() + Kx3*DT;
-	updateAcceleration(bola);
-	Kv4 = bola.getAcceleration();
-	Kx4 = bola.getVelocity() + Kv3 * DT;
-
-    Vel = bola.getVelocity() + (Kv1+Kv2*2.0f+Kv3*2.0f+Kv4)/6.0f*DT;
-    Pos = bola.getPosition() + (Kx1+Kx2*2.0f+Kx3*2.0f+Kx4)/6.0f*DT;
-
-	bola.setVelocity(Vel); // Update object's velocity
-	bola.setPosition(Pos); // Update object's position
-}
-
-void IntegrateVerlet (Sphere &sphere, float DT){
-        sphere.setPosition(sphere.getPosition() + sphere.getVelocity()*DT + 1.0f/2.0f*sphere.getAcceleration()*DT*DT);
-        glm::vec3 oldAcceleration=sphere.getAcceleration();
-        updateAcceleration(sphere);
-        sphere.setVelocity(sphere.getVelocity() + 1.0f/2.0f*(oldAcceleration*DT+sphere.getAcceleration()*DT));
-}
-
-void CheckBC(Sphere &sphere) {
-	if (sphere.getPosition().z <= R){
-			glm::vec3 oldVelocity;
-			glm::vec3 newVelocity;
-			oldVelocity = sphere.getVelocity();
-			newVelocity = oldVelocity;
-			newVelocity.z = -oldVelocity.z;
-			sphere.setVelocity(newVelocity);
-
-			glm::vec3 oldPosition;
-			glm::vec3 newPosition;
-			oldPosition = sphere.getPosition();
-			newPosition = oldPosition;
-			newPosition.z = R;
-			sphere.setPosition(newPosition);
-			
-		}
-
-		if (sphere.getPosition().x <= -2+R){
-			glm::vec3 oldVelocity;
-			glm::vec3 newVelocity;
-			oldVelocity = sphere.getVelocity();
-			newVelocity = oldVelocity;
-			newVelocity.x = -oldVelocity.x;
-			sphere.setVelocity(newVelocity);
-
-			glm::vec3 oldPosition;
-			glm::vec3 newPosition;
-			oldPosition = sphere.getPosition();
-			newPosition = oldPosition;
-			newPosition.x = -2+R;
-			sphere.setPosition(newPosition);
-			
-		}
-
-		if (sphere.getPosition().x >= 2-R){
-			glm::vec3 oldVelocity;
-			glm::vec3 newVelocity;
-			oldVelocity = sphere.getVelocity();
-			newVelocity = oldVelocity;
-			newVelocity.x = -oldVelocity.x;
-			sphere.setVelocity(newVelocity);
-
-			glm::vec3 oldPosition;
-			glm::vec3 newPosition;
-			oldPosition = sphere.getPosition();
-			newPosition = oldPosition;
-			newPosition.x = 2-R;
-			sphere.setPosition(newPosition);
-			
-		}
-
-		if (sphere.getPosition().y <= -2+R){
-			glm::vec3 oldVelocity;
-			glm::vec3 newVelocity;
-			oldVelocity = sphere.getVelocity();
-			newVelocity = oldVelocity;
-			newVelocity.y = -oldVelocity.y;
-			sphere.setVelocity(newVelocity);
-
-			glm::vec3 oldPosition;
-			glm::vec3 newPosition;
-			oldPosition = sphere.getPosition();
-			newPosition = oldPosition;
-			newPosition.y = -2+R;
-			sphere.setPosition(newPosition);
-			
-		}
-
-		if (sphere.getPosition().y >= 2-R){
-			glm::vec3 oldVelocity;
-			glm::vec3 newVelocity;
-			oldVelocity = sphere.getVelocity();
-			newVelocity = oldVelocity;
-			newVelocity.y = -oldVelocity.y;
-			sphere.setVelocity(newVelocity);
-
-			glm::vec3 oldPosition;
-			glm::vec3 newPosition;
-			oldPosition = sphere.getPosition();
-			newPosition = oldPosition;
-			newPosition.y = 2-R;
-			sphere.setPosition(newPosition);
-			
-		}
-		
-}
-
-void SphereCollision (Sphere &sph1, Sphere &sph2){
-	if (glm::distance(sph1.getPosition(),sph2.getPosition()) <= 2*R){
-			glm::vec3 oldPosition1;
-			glm::vec3 oldPosition2;
-			glm::vec3 oldVelocity1;
-			glm::vec3 oldVelocity2;
-			glm::vec3 newPosition1;
-			glm::vec3 newPosition2;
-			glm::vec3 newVelocity1;
-			glm::vec3 newVelocity2;
-
-			oldPosition1 = sph1.getPosition();
-			oldPosition2 = sph2.getPosition();
-			oldVelocity1 = sph1.getVelocity();
-			oldVelocity2 = sph2.getVelocity();
-
-			/*newVelocity1 = oldVelocity1 + 
-			     glm::length(oldPosition2 - oldPosition1)*
-				 glm::dot(oldVelocity2,(oldPosition2 - oldPosition1))/
-				 glm::dot((oldPosition2 - oldPosition1),(oldPosition2 - oldPosition1)) -
-				 glm::length(oldPosition1 - oldPosition2)*
-				 glm::dot(oldVelocity1,(oldPosition1 - oldPosition2))/
-				 glm::dot((oldPosition1 - oldPosition2),(oldPosition1 - oldPosition2));
-
-			newVelocity2 = oldVelocity2 + 
-			     glm::length(oldPosition2 - oldPosition1)*
-				 glm::dot(oldVelocity1,(oldPosition2 - oldPosition1))/
-				 glm::dot((oldPosition2 - oldPosition1),(oldPosition2 - oldPosition1)) -
-				 glm::length(oldPosition1 - oldPosition2)*
-				 glm::dot(oldVelocity2,(oldPosition1 - oldPosition2))/
-				 glm::dot((oldPosition1 - oldPosition2),(oldPosition1 - oldPosition2));*/
-
-			glm::vec3 vecx = oldPosition1 - oldPosition2;
-			glm::normalize(vecx);
-			float x1 = glm::dot(vecx,oldVelocity1);
-			glm::vec3 vecv1x = vecx * x1;
-			glm::vec3 vecv1y = oldVelocity1 - vecv1x;
-			float m1 = sph1.getMass();
-
-			vecx = -vecx;
-			float x2 = glm::dot(vecx,oldVelocity2);
-			glm::vec3 vecv2x = vecx * x2;
-			glm::vec3 vecv2y = oldVelocity2 - vecv2x;
-			float m2 = sph2.getMass();
-
-			newVelocity1 = vecv1x*(m1-m2)/(m1+m2)+vecv2x*(2*m2)/(m1+m2) + vecv1y;
-			newVelocity2 = vecv1x*(2*m1)/(m1+m2)+vecv2x*(m2-m1)/(m1+m2) + vecv2y;
-
-
-			sph1.setVelocity(newVelocity1);
-			sph2.setVelocity(newVelocity2);
+/* no window to show: a hidden window on GLFW's null platform (3.4+) with an EGL or OSMesa
+   context, whichever the machine has, so it also runs on servers without a display or GPU */
+GLFWwindow *create_headless_window( int width, int height ) {
+	const int context_apis[] = { GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API };
+	glfwWindowHint( GLFW_VISIBLE, GLFW_FALSE );
+	glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 4 );
+	glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 1 );
+	glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
+	for ( int api : context_apis ) {
+		glfwWindowHint( GLFW_CONTEXT_CREATION_API, api );
+		GLFWwindow *window = glfwCreateWindow( width, height, "headless", NULL, NULL );
+		if ( window ) {
+			return window;
 		}
+	}
+	return NULL;
 }
 
-int main() {
+int main( int argc, char **argv ) {
 	GLFWwindow *window;
 	const GLubyte *renderer;
 	const GLubyte *version;
 	int sectorCount = 10;
 	int stackCount = 10;
-	float fps = 0.0f;
 	float frame_time = 0.0f;
 	float frame_time_cummulated = 0.0f;
+	bool headless = false;
+	int headless_frames = 600;
+	const char *frames_dir = "frames";
+	int frame_number = 0;
+	IntegratorKind integrator = INTEGRATOR_VERLET;
+	const char *feed_name = NULL;
+	double sim_time = 0.0;
 	
 	Sphere sphere1;
-	Sphere sphere2;
+	InstanceBuffer sphere_instances;
 	Plane plane1;
 	Line line1;
+	GpuTimer gpu_timer;
+	FrameStats frame_stats;
+	OffscreenTarget offscreen;
+	FrameWriter frame_writer;
+	SimFeedWriter sim_feed;
+	ProgramCache program_cache;
+
+	for ( int i = 1; i < argc; i++ ) {
+		if ( strcmp( argv[i], "--headless" ) == 0 ) {
+			headless = true;
+		} else if ( strcmp( argv[i], "--frames" ) == 0 && i + 1 < argc ) {
+			headless_frames = atoi( argv[++i] );
+		} else if ( strcmp( argv[i], "--out" ) == 0 && i + 1 < argc ) {
+			frames_dir = argv[++i];
+		} else if ( strcmp( argv[i], "--feed" ) == 0 && i + 1 < argc ) {
+			feed_name = argv[++i];
+		} else if ( strcmp( argv[i], "--integrator" ) == 0 && i + 1 < argc && parseIntegrator( argv[i + 1], integrator ) ) {
+			i++;
+		} else {
+			std::cout << "usage: " << argv[0] << " [--integrator euler|rk4|verlet] [--feed name] [--headless [--frames N] [--out dir]]" << std::endl;
+			return 1;
+		}
+	}
 
 	restart_gl_log();
 	auto t_start = std::chrono::high_resolution_clock::now();
@@ -280,25 +145,68 @@ int main() {
 	
 	GLuint vbo;
 	GLuint vao;
+	// normals arrive octahedral-encoded in two normalized bytes (see mesh_pack.hpp)
+#define OCT_DECODE \
+		"vec3 octDecode( vec2 e ) {" \
+		"  vec3 n = vec3( e, 1.0 - abs( e.x ) - abs( e.y ) );" \
+		"  if ( n.z < 0.0 ) n.xy = ( 1.0 - abs( n.yx ) ) * vec2( n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0 );" \
+		"  return normalize( n );" \
+		"}"
 	const char *vertex_shader = "#version 410\n"
 		"in vec3 vp;"
+		"in vec2 vn;"
+		"uniform vec3 pos_scale;"
+		"uniform vec3 pos_offset;"
 		"uniform mat4 model;"
 		"uniform mat4 view;"
 		"uniform mat4 proj;"
+		"out vec3 normal;"
+		OCT_DECODE
 		"void main() {"
 		"  gl_PointSize = 10.0;"
-		"  gl_Position = proj * view * model * vec4( vp, 1.0 );"
+		"  normal = mat3( model ) * octDecode( vn );"
+		"  gl_Position = proj * view * model * vec4( pos_offset + pos_scale * vp, 1.0 );"
 		"}";
 
+	// spheres are drawn instanced, one 3x4 body transform (rotation | position) per instance
+	const char *sphere_vertex_shader = "#version 410\n"
+		"in vec3 vp;"
+		"in vec2 vn;"
+		"in vec4 instance_row0;"
+		"in vec4 instance_row1;"
+		"in vec4 instance_row2;"
+		"uniform vec3 pos_scale;"
+		"uniform vec3 pos_offset;"
+		"uniform mat4 view;"
+		"uniform mat4 proj;"
+		"out vec3 normal;"
+		OCT_DECODE
+		"void main() {"
+		"  vec4 p = vec4( pos_offset + pos_scale * vp, 1.0 );"
+		"  vec3 world = vec3( dot( instance_row0, p ), dot( instance_row1, p ), dot( instance_row2, p ) );"
+		"  vec3 n = octDecode( vn );"
+		"  normal = vec3( dot( instance_row0.xyz, n ), dot( instance_row1.xyz, n ), dot( instance_row2.xyz, n ) );"
+		"  gl_Position = proj * view * vec4( world, 1.0 );"
+		"}";
+
+	// the old flat grey, shaded a little by a light over the camera's shoulder
 	const char *fragment_shader = "#version 410\n"
+		"in vec3 normal;"
 		"out vec4 frag_colour;"
 		"void main() {"
-		"  frag_colour = vec4( 0.5, 0.5, 0.5, 1.0 );"
+		"  float diffuse = max( dot( normalize( normal ), normalize( vec3( 0.3, -0.5, 0.8 ) ) ), 0.0 );"
+		"  frag_colour = vec4( vec3( 0.5 * ( 0.6 + 0.4 * diffuse ) ), 1.0 );"
 		"}";
-	GLuint shader_programme, vs, fs;
+	GLuint shader_programme;
+	GLuint sphere_programme;
 
 	// start GL context and O/S window using the GLFW helper library
 	glfwSetErrorCallback( glfw_error_callback );
+#ifdef GLFW_PLATFORM_NULL
+	if ( headless ) {
+		glfwInitHint( GLFW_PLATFORM, GLFW_PLATFORM_NULL );
+	}
+#endif
 	if ( !glfwInit() ) {
 		return 1;
 	}
@@ -313,7 +221,11 @@ int main() {
 		vmode->width, vmode->height, "Extended GL Init", mon, NULL
 	);*/
 
-	window = glfwCreateWindow( g_gl_width, g_gl_height, "Extended Init", NULL, NULL );
+	if ( headless ) {
+		window = create_headless_window( g_gl_width, g_gl_height );
+	} else {
+		window = glfwCreateWindow( g_gl_width, g_gl_height, "Extended Init", NULL, NULL );
+	}
 	if ( !window ) {
 		glfwTerminate();
 		return 1;
@@ -323,9 +235,17 @@ int main() {
 	glfwMakeContextCurrent( window );
 
 	// start GLEW extension handler
+	// (a GLX-only GLEW reports an error on EGL contexts after it has loaded the core entry points)
 	glewExperimental = GL_TRUE;
 	glewInit();
 
+	if ( headless ) {
+		if ( !offscreen.init( g_gl_width, g_gl_height ) || !frame_writer.start( frames_dir, g_gl_width, g_gl_height ) ) {
+			glfwTerminate();
+			return 1;
+		}
+	}
+
 	// get version info
 	renderer = glGetString( GL_RENDERER ); // get renderer string
 	version = glGetString( GL_VERSION );	 // version as a string
@@ -334,35 +254,62 @@ int main() {
 	glEnable( GL_DEPTH_TEST ); // enable depth-testing
 	glEnable(GL_PROGRAM_POINT_SIZE);
 	glDepthFunc( GL_LESS );		 // depth-testing interprets a smaller value as "closer"
+
+	gpu_timer.init(NUM_PASSES);
+	// frames slower than 1.5 refresh intervals count as dropped
+	GLFWmonitor *monitor = glfwGetPrimaryMonitor();
+	const GLFWvidmode *vmode = monitor ? glfwGetVideoMode(monitor) : NULL;
+	if (vmode && vmode->refreshRate > 0) {
+		frame_stats.setTargetInterval(1.0f / vmode->refreshRate);
+	}
 	
-	vs = glCreateShader( GL_VERTEX_SHADER );
-	glShaderSource( vs, 1, &vertex_shader, NULL );
-	glCompileShader( vs );
-	fs = glCreateShader( GL_FRAGMENT_SHADER );
-	glShaderSource( fs, 1, &fragment_shader, NULL );
-	glCompileShader( fs );
-	shader_programme = glCreateProgram();
-	glAttachShader( shader_programme, fs );
-	glAttachShader( shader_programme, vs );
-	glLinkProgram( shader_programme );
+	// linked programs are kept in shader_cache/ so later launches skip compile and link
+	program_cache.init( "shader_cache", GL_LOG_FILE );
+	shader_programme = program_cache.build( vertex_shader, fragment_shader );
+	sphere_programme = program_cache.build( sphere_vertex_shader, fragment_shader );
+	if ( !shader_programme || !sphere_programme ) {
+		glfwTerminate();
+		return 1;
+	}
 	glUseProgram( shader_programme );
 	
-	GLuint vp = glGetAttribLocation(shader_programme, "vp");
-	sphere1.init(vp,R);
-	sphere1.setMass(1.0f);
-	sphere1.setPosition(glm::vec3(1.0f,1.0f,2.0f));
-	sphere1.setVelocity(glm::vec3(-1.0f,-0.5f,0.0f));
-	updateAcceleration(sphere1);
-
-	sphere2.init(vp,R);
-	sphere2.setMass(1.0f);
-	sphere2.setPosition(glm::vec3(-1.0f,-1.0f,2.0f));
-	sphere2.setVelocity(glm::vec3(0.0f,0.0f,0.0f));
-	updateAcceleration(sphere2);
-
-	plane1.init(vp,0.0f);
-
-	line1.init(vp,glm::vec3(0.0f,0.0f,0.0f),glm::vec3(0.0f,0.0f,4.0f));
+	// meshes are quantized, they restore positions through pos_scale/pos_offset
+	VertexLayout layout;
+	layout.position = glGetAttribLocation(shader_programme, "vp");
+	layout.normal = glGetAttribLocation(shader_programme, "vn");
+	layout.posScale = glGetUniformLocation(shader_programme, "pos_scale");
+	layout.posOffset = glGetUniformLocation(shader_programme, "pos_offset");
+	VertexLayout sphere_layout;
+	sphere_layout.position = glGetAttribLocation(sphere_programme, "vp");
+	sphere_layout.normal = glGetAttribLocation(sphere_programme, "vn");
+	sphere_layout.posScale = glGetUniformLocation(sphere_programme, "pos_scale");
+	sphere_layout.posOffset = glGetUniformLocation(sphere_programme, "pos_offset");
+	sphere1.init(sphere_layout,R);
+
+	// the integrator/force/boundary combination is chosen here, once, not per step
+	Bodies bodies;
+	int body1 = bodies.add(glm::vec3(1.0f,1.0f,2.0f), glm::vec3(-1.0f,-0.5f,0.0f), 1.0f);
+	bodies.add(glm::vec3(-1.0f,-1.0f,2.0f), glm::vec3(0.0f,0.0f,0.0f), 1.0f);
+	bodies.angularVelocity[bodies.slot[body1]] = glm::vec3(0.0f, 0.0f, glm::radians(90.0f));
+
+	sphere_instances.init(bodies.size(), transformFloats);
+	GLint instance_rows[3] = {
+		glGetAttribLocation(sphere_programme, "instance_row0"),
+		glGetAttribLocation(sphere_programme, "instance_row1"),
+		glGetAttribLocation(sphere_programme, "instance_row2")
+	};
+	sphere1.setInstances(sphere_instances.getBuffer(), instance_rows);
+	Stepper stepper = selectStepper(integrator, FORCE_GRAVITY, BOUNDARY_BOX);
+	stepper.prime(bodies);
+	BroadPhase broad_phase;
+	BodyReorder body_reorder;
+	if ( feed_name ) {
+		sim_feed.open( feed_name, bodies.size() );
+	}
+
+	plane1.init(layout,0.0f);
+
+	line1.init(layout,glm::vec3(0.0f,0.0f,0.0f),glm::vec3(0.0f,0.0f,4.0f));
 	
 	GLint uniModel = glGetUniformLocation(shader_programme, "model");
 
@@ -375,53 +322,84 @@ int main() {
 
     GLint uniView = glGetUniformLocation(shader_programme, "view");
     glUniformMatrix4fv(uniView, 1, GL_FALSE, glm::value_ptr(view));
+    glProgramUniformMatrix4fv(sphere_programme, glGetUniformLocation(sphere_programme, "view"), 1, GL_FALSE, glm::value_ptr(view));
 
     glm::mat4 proj = glm::perspective(glm::radians(45.0f), g_gl_width / g_gl_height, 1.0f, 10.0f);
     GLint uniProj = glGetUniformLocation(shader_programme, "proj");
     glUniformMatrix4fv(uniProj, 1, GL_FALSE, glm::value_ptr(proj));
-
+    glProgramUniformMatrix4fv(sphere_programme, glGetUniformLocation(sphere_programme, "proj"), 1, GL_FALSE, glm::value_ptr(proj));
+
+	// every program/mesh pair drawn once before the first timed frame
+	program_cache.addWarmUp( shader_programme, [&] { plane1.draw(); } );
+	program_cache.addWarmUp( sphere_programme, [&] { sphere1.drawInstanced(1); } );
+	program_cache.addWarmUp( shader_programme, [&] { line1.draw(); } );
+	if ( headless ) {
+		offscreen.bind();	// warm up against the framebuffer the frames will really use
+	}
+	program_cache.warmUp();
+	FrameArena::resetAll();	// mesh building is done with its scratch
 	
-	while ( !glfwWindowShouldClose( window ) ) {
+	PROFILE_THREAD_NAME("main");
+	while ( !glfwWindowShouldClose( window ) && !( headless && frame_number >= headless_frames ) ) {
+		PROFILE_ZONE("frame");
 		auto t_now = std::chrono::high_resolution_clock::now();
         float time = std::chrono::duration_cast<std::chrono::duration<float>>(t_now - t_start).count();
+		// headless runs step a fixed 60 Hz so the recording doesn't depend on how fast it renders
+		float step_time = frame_time;
+		if ( headless ) {
+			step_time = 1.0f / 60.0f;
+			time = frame_number * step_time;
+			offscreen.bind();
+		}
 		// wipe the drawing surface clear
 		glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 		glViewport( 0, 0, g_gl_width, g_gl_height );
 
-		glm::mat4 model = glm::mat4(1.0f);
-		glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(model)); //sets the uniform matrix model in shader
-		plane1.draw();
-		//line1.draw();
+		{
+			PROFILE_ZONE("draw plane");
+			glm::mat4 model = glm::mat4(1.0f);
+			glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(model)); //sets the uniform matrix model in shader
+			gpu_timer.begin(PASS_PLANE);
+			plane1.draw();
+			gpu_timer.end(PASS_PLANE);
+			//line1.draw();
+		}
 
-		IntegrateVerlet(sphere1,frame_time);
-		CheckBC(sphere1);
-		IntegrateVerlet(sphere2,frame_time);
-		CheckBC(sphere2);
-		SphereCollision(sphere1,sphere2);
-		
-		glm::mat4 model1 = glm::mat4(1.0f);
-		model1 = glm::translate(
-            model1,
-            sphere1.getPosition()
-        );
+		{
+			PROFILE_ZONE("integrate + boundary");
+			stepper.step(bodies,step_time);
+		}
+		{
+			PROFILE_ZONE("reorder");
+			body_reorder.update(bodies);
+		}
+		{
+			PROFILE_ZONE("collision");
+			broad_phase.collide(bodies);
+		}
+		sim_time += step_time;
+		if ( sim_feed.isOpen() ) {
+			PROFILE_ZONE("publish");
+			sim_feed.publish(bodies, sim_time);
+		}
 		
-        model1 = glm::rotate(
-            model1,
-			time * glm::radians(90.0f), 
-            glm::vec3(0.0f, 0.0f, time * 0.1* 1.0f)
-        );
-
-		glm::mat4 model2 = glm::mat4(1.0f);
-		model2 = glm::translate(
-            model2,
-            sphere2.getPosition()
-        );
-
-		glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(model1)); //sets the uniform matrix model in shader
-		sphere1.draw();
-
-		glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(model2)); //sets the uniform matrix model in shader
-		sphere2.draw();
+		{
+			// orientations stepped with the positions; drawing only packs them into the instance buffer
+			PROFILE_ZONE("transforms");
+			float *transforms = sphere_instances.map(bodies.size());
+			if ( transforms ) {
+				packTransforms(bodies, transforms);
+				sphere_instances.unmap();
+			}
+		}
+		{
+			PROFILE_ZONE("draw spheres");
+			gpu_timer.begin(PASS_SPHERES);
+			glUseProgram( sphere_programme );
+			sphere1.drawInstanced(bodies.size());
+			glUseProgram( shader_programme );
+			gpu_timer.end(PASS_SPHERES);
+		}
 		// update other events like input handling
 		glfwPollEvents();
 		if ( GLFW_PRESS == glfwGetKey( window, GLFW_KEY_ESCAPE ) ) {
@@ -429,32 +407,61 @@ int main() {
 		}
 		
 		// put the stuff we've been drawing onto the display
-		glfwSwapBuffers( window );
+		if ( headless ) {
+			PROFILE_ZONE("readback");
+			offscreen.readback( frame_writer );
+		} else {
+			PROFILE_ZONE("swap");
+			glfwSwapBuffers( window );
+		}
+		gpu_timer.endFrame();
+		// everything transient this frame (broad phase, sort, reorder scratch) goes at once
+		FrameArena::resetAll();
+		frame_number++;
 		auto t_after_frame_display = std::chrono::high_resolution_clock::now();
 		frame_time = std::chrono::duration_cast<std::chrono::duration<float>>(t_after_frame_display - t_now).count();
-		fps = 1/frame_time;
 		frame_time_cummulated += frame_time;
 
-		log_file.open(GL_LOG_FILE,std::ios::app);
-		log_file << "t_now: " << t_now << std::endl;
-		log_file << "t_after_frame_display: " << t_after_frame_display << std::endl;
-		log_file << "frame_time: " << frame_time << std::endl;
-		log_file << "fps: " << fps << std::endl;
-		log_file << "time: " << time << std::endl;
-		log_file.close();
+		frame_stats.add(frame_time);
+
+		// report once a second rather than touching the log and the title every frame
 		if (frame_time_cummulated >= 1.0f){
-			std::string fps_title[] = {"OpenGL @ FPS: "};
-			fps_title[0].append(std::to_string(fps));
-			glfwSetWindowTitle( window,  fps_title[0].c_str() );
+			char report[256];
+			std::snprintf(report, sizeof(report),
+				"OpenGL @ %d frames  p50 %.1f  p95 %.1f  p99 %.1f  max %.1f ms  dropped %d  |  GPU plane %.3f  spheres %.3f ms  |  arena %.1f KB",
+				frame_stats.getFrames(), frame_stats.percentileMs(0.50f), frame_stats.percentileMs(0.95f),
+				frame_stats.percentileMs(0.99f), frame_stats.maxMs(), frame_stats.getDropped(),
+				gpu_timer.averageMs(PASS_PLANE), gpu_timer.averageMs(PASS_SPHERES),
+				FrameArena::totalHighWater() / 1024.0);
+			glfwSetWindowTitle( window, report );
+
+			log_file.open(GL_LOG_FILE,std::ios::app);
+			log_file << "t_now: " << t_now << " time: " << time << " " << report << std::endl;
+			log_file.close();
+
+			frame_stats.reset();
+			gpu_timer.reset();
 			frame_time_cummulated = 0.0f;
 		}
 		
 	}
 
-	// close GL context and any other GLFW resources
-	glfwTerminate();
+	PROFILE_WRITE("profile.json");
+
+	if ( headless ) {
+		offscreen.finish( frame_writer );
+		frame_writer.stop();
+		offscreen.cleanup();
+	}
+	gpu_timer.cleanup();
+	sim_feed.close();
+	// GL objects go while the context is still current
 	sphere1.cleanup();
+	sphere_instances.cleanup();
 	plane1.cleanup();
 	line1.cleanup();
+
+	// close GL context and any other GLFW resources
+	glfwTerminate();
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "gpu_timer.hpp"
+
+GpuTimer::GpuTimer()
+{
+    isInited = false;
+    passes = 0;
+    frame = 0;
+}
+
+GpuTimer::~GpuTimer()
+{
+
+}
+
+void GpuTimer::init(int numPasses)
+{
+    passes = numPasses;
+    frame = 0;
+    queries.assign(frameLatency * passes, 0);
+    pending.assign(frameLatency * passes, false);
+    active.assign(passes, false);
+    totalMs.assign(passes, 0.0);
+    samples.assign(passes, 0);
+
+    glGenQueries(queries.size(), &queries[0]);
+
+    isInited = true;
+}
+
+void GpuTimer::cleanup()
+{
+    if (!isInited) {
+        return;
+    }
+    glDeleteQueries(queries.size(), &queries[0]);
+
+    isInited = false;
+    queries.clear();
+    pending.clear();
+}
+
+void GpuTimer::begin(int pass)
+{
+    int slot = frame * passes + pass;
+    // the GPU is more than frameLatency frames behind, skip this sample rather than wait
+    if (!isInited || pending[slot]) {
+        active[pass] = false;
+        return;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+    active[pass] = true;
+}
+
+void GpuTimer::end(int pass)
+{
+    if (!active[pass]) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    pending[frame * passes + pass] = true;
+    active[pass] = false;
+}
+
+void GpuTimer::endFrame()
+{
+    if (!isInited) {
+        return;
+    }
+    collect();
+    frame = (frame + 1) % frameLatency;
+}
+
+void GpuTimer::collect()
+{
+    for (int slot = 0; slot < (int)queries.size(); slot++) {
+        if (!pending[slot]) {
+            continue;
+        }
+        GLint available = 0;
+        glGetQueryObjectiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            continue;
+        }
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &elapsed);
+        pending[slot] = false;
+
+        int pass = slot % passes;
+        totalMs[pass] += elapsed / 1.0e6;
+        samples[pass]++;
+    }
+}
+
+float GpuTimer::averageMs(int pass) const
+{
+    return samples[pass] ? totalMs[pass] / samples[pass] : 0.0f;
+}
+
+void GpuTimer::reset()
+{
+    totalMs.assign(passes, 0.0);
+    samples.assign(passes, 0);
+}
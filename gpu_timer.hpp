@@ -0,0 +1,35 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <GL/glew.h>
+#include <vector>
+
+// GL_TIME_ELAPSED queries for a fixed set of passes, kept in a ring a few frames deep
+// so results are read back once the GPU has them instead of stalling on them
+class GpuTimer
+{
+public:
+    GpuTimer();
+    ~GpuTimer();
+    void init(int numPasses);
+    void cleanup();
+    void begin(int pass);   // passes can't nest, GL allows one GL_TIME_ELAPSED query at a time
+    void end(int pass);
+    void endFrame();        // collect whatever finished and move on to the next ring slot
+    float averageMs(int pass) const;    // since the last reset()
+    void reset();
+
+private:
+    static const int frameLatency = 4;
+    bool isInited;
+    int passes, frame;
+    std::vector<GLuint> queries;    // frameLatency * passes
+    std::vector<bool> pending;      // issued and not read back yet
+    std::vector<bool> active;       // begin() issued a query this frame
+    std::vector<double> totalMs;
+    std::vector<int> samples;
+
+    void collect();
+};
+
+#endif // GPU_TIMER_H
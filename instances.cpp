@@ -0,0 +1,67 @@
+#include "instances.hpp"
+
+#include <iostream>
+
+InstanceBuffer::InstanceBuffer()
+{
+    isInited = false;
+    vbo = 0;
+    capacity = 0;
+    floatsPerInstance = 0;
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+
+}
+
+void InstanceBuffer::init(int maxInstances, int floatsPerInstance)
+{
+    this->floatsPerInstance = floatsPerInstance;
+    capacity = maxInstances;
+
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, capacity * floatsPerInstance * sizeof(GLfloat), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    isInited = true;
+}
+
+void InstanceBuffer::cleanup()
+{
+    if (!isInited) {
+        return;
+    }
+    if (vbo) {
+        glDeleteBuffers(1, &vbo);
+    }
+
+    isInited = false;
+    vbo = 0;
+    capacity = 0;
+}
+
+float *InstanceBuffer::map(int count)
+{
+    if (!isInited) {
+        std::cout << "please call init() before map()" << std::endl;
+        return NULL;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (count > capacity) {
+        capacity = count + count / 2;
+        glBufferData(GL_ARRAY_BUFFER, capacity * floatsPerInstance * sizeof(GLfloat), NULL, GL_STREAM_DRAW);
+    }
+    GLsizeiptr bytes = count * floatsPerInstance * sizeof(GLfloat);
+    float *data = (float *)glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return data;
+}
+
+void InstanceBuffer::unmap()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
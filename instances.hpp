@@ -0,0 +1,26 @@
+#ifndef INSTANCES_H
+#define INSTANCES_H
+
+#include <GL/glew.h>
+
+// per-instance vertex buffer the CPU refills every frame: map() orphans the old contents so
+// the write never waits on draws still reading last frame's transforms
+class InstanceBuffer
+{
+public:
+    InstanceBuffer();
+    ~InstanceBuffer();
+    void init(int maxInstances, int floatsPerInstance);
+    void cleanup();
+    float *map(int count);  // NULL if the buffer can't be mapped
+    void unmap();
+    GLuint getBuffer() const { return vbo; }
+
+private:
+    bool isInited;
+    GLuint vbo;
+    int capacity;           // instances
+    int floatsPerInstance;
+};
+
+#endif // INSTANCES_H
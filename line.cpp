@@ -21,11 +21,11 @@ Line::~Line()
 
 }
 
-void Line::init(GLuint vertexPositionID, glm::vec3 a, glm::vec3 b)
+void Line::init(const VertexLayout &layout, glm::vec3 a, glm::vec3 b)
 {
     
-    std::vector<GLfloat> vertices;
-    std::vector<GLuint> indices;
+    ArenaVector<GLfloat> vertices = arenaVector<GLfloat>(6);
+    ArenaVector<GLuint> indices = arenaVector<GLuint>(2);
        
     vertices.push_back(a.x);
     vertices.push_back(a.y);
@@ -38,20 +38,14 @@ void Line::init(GLuint vertexPositionID, glm::vec3 a, glm::vec3 b)
     indices.push_back(0);
     indices.push_back(1);
     
+    // no normals: a line isn't lit
+    ArenaVector<PackedVertex> packed = arenaVector<PackedVertex>(2);
+    bounds = packVertices(vertices, arenaVector<GLfloat>(), packed);
+    this->layout = layout;
+
     glGenVertexArrays(1, &line_vao);
     glBindVertexArray(line_vao);
-
-    glGenBuffers(1, &line_vboVertex);
-    glBindBuffer(GL_ARRAY_BUFFER, line_vboVertex);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), &vertices[0], GL_STATIC_DRAW);
-
-    glVertexAttribPointer(vertexPositionID, 3, GL_FLOAT, GL_FALSE, 0, NULL);
-    glEnableVertexAttribArray (vertexPositionID);
-
-    glGenBuffers(1, &line_vboIndex);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, line_vboIndex);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
-
+    indexType = uploadMesh(layout, packed, indices, line_vboVertex, line_vboIndex);
     glBindVertexArray(0);
 
     numsToDraw = indices.size();
@@ -89,5 +83,6 @@ void Line::draw()
     // draw line
     glPolygonMode(GL_FRONT_AND_BACK,GL_LINE);
     glBindVertexArray(line_vao);
-    glDrawElements(GL_LINES, numsToDraw, GL_UNSIGNED_INT, NULL);
+    setMeshBounds(layout, bounds);
+    glDrawElements(GL_LINES, numsToDraw, indexType, NULL);
 }
\ No newline at end of file
@@ -3,13 +3,14 @@
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
+#include "mesh_pack.hpp"
 
 class Line
 {
 public:
     Line();
     ~Line();
-    void init(GLuint vertexPositionID, glm::vec3 a, glm::vec3 b);
+    void init(const VertexLayout &layout, glm::vec3 a, glm::vec3 b);
     void cleanup();
     void draw();
 
@@ -17,6 +18,9 @@ private:
     bool isInited;
     GLuint line_vao, line_vboVertex, line_vboIndex;
     int numsToDraw;
+    GLenum indexType;
+    VertexLayout layout;
+    MeshBounds bounds;
 };
 
 #endif // LINE_H
\ No newline at end of file
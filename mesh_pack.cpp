@@ -0,0 +1,257 @@
+#include "mesh_pack.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <algorithm>
+
+static GLshort quantizeSnorm16(float v)
+{
+    v = std::max(-1.0f, std::min(1.0f, v));
+    return (GLshort)std::lround(v * 32767.0f);
+}
+
+static GLbyte quantizeSnorm8(float v)
+{
+    v = std::max(-1.0f, std::min(1.0f, v));
+    return (GLbyte)std::lround(v * 127.0f);
+}
+
+void octEncode(const glm::vec3 &n, GLbyte encoded[2])
+{
+    float sum = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if (sum == 0.0f) {
+        encoded[0] = 0;
+        encoded[1] = 0;
+        return;
+    }
+    glm::vec2 e(n.x / sum, n.y / sum);
+    if (n.z < 0.0f) {
+        glm::vec2 folded((1.0f - std::fabs(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f),
+            (1.0f - std::fabs(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f));
+        e = folded;
+    }
+    encoded[0] = quantizeSnorm8(e.x);
+    encoded[1] = quantizeSnorm8(e.y);
+}
+
+MeshBounds packVertices(const ArenaVector<GLfloat> &positions, const ArenaVector<GLfloat> &normals,
+    ArenaVector<PackedVertex> &packed)
+{
+    const int n = positions.size() / 3;
+    glm::vec3 lo(positions[0], positions[1], positions[2]);
+    glm::vec3 hi = lo;
+    for (int i = 1; i < n; i++) {
+        glm::vec3 p(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+    MeshBounds bounds;
+    bounds.offset = (lo + hi) * 0.5f;
+    bounds.scale = (hi - lo) * 0.5f;
+    // a flat axis (plane z, an axis-aligned line) still needs a non-zero scale to divide by
+    glm::vec3 divisor(bounds.scale.x > 0.0f ? bounds.scale.x : 1.0f,
+        bounds.scale.y > 0.0f ? bounds.scale.y : 1.0f,
+        bounds.scale.z > 0.0f ? bounds.scale.z : 1.0f);
+
+    packed.resize(n);
+    for (int i = 0; i < n; i++) {
+        glm::vec3 p(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+        glm::vec3 t = (p - bounds.offset) / divisor;
+        packed[i].position[0] = quantizeSnorm16(t.x);
+        packed[i].position[1] = quantizeSnorm16(t.y);
+        packed[i].position[2] = quantizeSnorm16(t.z);
+        glm::vec3 normal(0.0f);
+        if (!normals.empty()) {
+            normal = glm::vec3(normals[3 * i], normals[3 * i + 1], normals[3 * i + 2]);
+        }
+        octEncode(normal, packed[i].normal);
+    }
+    return bounds;
+}
+
+// ---------------------------------------------------------------- vertex cache
+
+static const int forsythCacheSize = 32;
+
+static float vertexScore(int cachePosition, int remaining)
+{
+    if (remaining == 0) {
+        return -1.0f;
+    }
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            score = 0.75f;  // used by the last triangle, fixed so the order doesn't favour one of them
+        } else {
+            score = std::pow(1.0f - (cachePosition - 3) / (float)(forsythCacheSize - 3), 1.5f);
+        }
+    }
+    // vertices with few triangles left get priority so they don't end up orphaned
+    return score + 2.0f / std::sqrt((float)remaining);
+}
+
+void optimizeVertexCache(ArenaVector<GLuint> &indices, int vertexCount)
+{
+    const int triangles = indices.size() / 3;
+    if (triangles == 0) {
+        return;
+    }
+
+    // triangles of each vertex
+    ArenaVector<int> remaining = arenaVector<int>(vertexCount), first = arenaVector<int>(vertexCount + 1);
+    ArenaVector<int> adjacency = arenaVector<int>(indices.size());
+    remaining.resize(vertexCount, 0);
+    first.resize(vertexCount + 1, 0);
+    adjacency.resize(indices.size());
+    for (GLuint index : indices) {
+        remaining[index]++;
+    }
+    for (int v = 0; v < vertexCount; v++) {
+        first[v + 1] = first[v] + remaining[v];
+    }
+    ArenaVector<int> fill = arenaVector<int>(vertexCount);
+    fill.assign(first.begin(), first.end() - 1);
+    for (int t = 0; t < triangles; t++) {
+        for (int k = 0; k < 3; k++) {
+            adjacency[fill[indices[3 * t + k]]++] = t;
+        }
+    }
+
+    ArenaVector<float> score = arenaVector<float>(vertexCount);
+    score.resize(vertexCount);
+    for (int v = 0; v < vertexCount; v++) {
+        score[v] = vertexScore(-1, remaining[v]);
+    }
+    ArenaVector<float> triangleScore = arenaVector<float>(triangles);
+    ArenaVector<char> emitted = arenaVector<char>(triangles);
+    triangleScore.resize(triangles);
+    emitted.resize(triangles, 0);
+    for (int t = 0; t < triangles; t++) {
+        triangleScore[t] = score[indices[3 * t]] + score[indices[3 * t + 1]] + score[indices[3 * t + 2]];
+    }
+
+    ArenaVector<GLuint> ordered = arenaVector<GLuint>(indices.size());
+    ArenaVector<int> cache = arenaVector<int>(forsythCacheSize + 3), nextCache = arenaVector<int>(forsythCacheSize + 3);
+    int best = (int)(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+    int scan = 0;
+    while (best >= 0) {
+        emitted[best] = 1;
+        nextCache.clear();
+        for (int k = 0; k < 3; k++) {
+            int v = indices[3 * best + k];
+            ordered.push_back(v);
+            remaining[v]--;
+            nextCache.push_back(v);
+        }
+        for (int v : cache) {
+            if (v != nextCache[0] && v != nextCache[1] && v != nextCache[2]) {
+                nextCache.push_back(v);
+            }
+        }
+        // vertices that just fell out of the cache need their score dropped too
+        for (size_t i = forsythCacheSize; i < nextCache.size(); i++) {
+            score[nextCache[i]] = vertexScore(-1, remaining[nextCache[i]]);
+        }
+        if ((int)nextCache.size() > forsythCacheSize) {
+            nextCache.resize(forsythCacheSize);
+        }
+        cache.swap(nextCache);
+        for (int i = 0; i < (int)cache.size(); i++) {
+            score[cache[i]] = vertexScore(i, remaining[cache[i]]);
+        }
+
+        // the next triangle is the best one touching the cache
+        best = -1;
+        float bestScore = -1.0f;
+        for (int v : cache) {
+            for (int a = first[v]; a < first[v + 1]; a++) {
+                int t = adjacency[a];
+                if (emitted[t]) {
+                    continue;
+                }
+                triangleScore[t] = score[indices[3 * t]] + score[indices[3 * t + 1]] + score[indices[3 * t + 2]];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+        // nothing left around the cache: carry on from the first triangle not emitted
+        if (best < 0) {
+            while (scan < triangles && emitted[scan]) {
+                scan++;
+            }
+            if (scan < triangles) {
+                best = scan;
+            }
+        }
+    }
+    indices.swap(ordered);
+}
+
+float cacheMissRatio(const ArenaVector<GLuint> &indices, int cacheSize)
+{
+    if (indices.size() < 3) {
+        return 0.0f;
+    }
+    ArenaVector<GLuint> fifo = arenaVector<GLuint>(cacheSize + 1);
+    int misses = 0;
+    for (GLuint index : indices) {
+        if (std::find(fifo.begin(), fifo.end(), index) == fifo.end()) {
+            misses++;
+            fifo.push_back(index);
+            if ((int)fifo.size() > cacheSize) {
+                fifo.erase(fifo.begin());
+            }
+        }
+    }
+    return misses / (float)(indices.size() / 3);
+}
+
+// ---------------------------------------------------------------- upload
+
+GLenum uploadMesh(const VertexLayout &layout, const ArenaVector<PackedVertex> &vertices,
+    const ArenaVector<GLuint> &indices, GLuint &vboVertex, GLuint &vboIndex)
+{
+    glGenBuffers(1, &vboVertex);
+    glBindBuffer(GL_ARRAY_BUFFER, vboVertex);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(PackedVertex), &vertices[0], GL_STATIC_DRAW);
+
+    glVertexAttribPointer(layout.position, 3, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void *)offsetof(PackedVertex, position));
+    glEnableVertexAttribArray(layout.position);
+    if (layout.normal >= 0) {
+        glVertexAttribPointer(layout.normal, 2, GL_BYTE, GL_TRUE, sizeof(PackedVertex), (void *)offsetof(PackedVertex, normal));
+        glEnableVertexAttribArray(layout.normal);
+    }
+
+    glGenBuffers(1, &vboIndex);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboIndex);
+    if (vertices.size() <= 65536) {
+        ArenaVector<GLushort> shortIndices = arenaVector<GLushort>(indices.size());
+        shortIndices.assign(indices.begin(), indices.end());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(GLushort), &shortIndices[0], GL_STATIC_DRAW);
+        return GL_UNSIGNED_SHORT;
+    }
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+    return GL_UNSIGNED_INT;
+}
+
+void setMeshBounds(const VertexLayout &layout, const MeshBounds &bounds)
+{
+    glUniform3fv(layout.posScale, 1, &bounds.scale[0]);
+    glUniform3fv(layout.posOffset, 1, &bounds.offset[0]);
+}
+
+std::string meshStats(int vertexCount, const ArenaVector<GLuint> &indices, float missRatioBefore)
+{
+    int indexSize = vertexCount <= 65536 ? sizeof(GLushort) : sizeof(GLuint);
+    char line[256];
+    // against the old upload: float xyz only, no normals
+    std::snprintf(line, sizeof(line),
+        "vertices %d: %d bytes incl. normals (float xyz: %d)  indices %d: %d bytes (GLuint: %d)  ACMR %.3f -> %.3f",
+        vertexCount, vertexCount * (int)sizeof(PackedVertex), vertexCount * 3 * (int)sizeof(GLfloat),
+        (int)indices.size(), (int)indices.size() * indexSize, (int)(indices.size() * sizeof(GLuint)),
+        missRatioBefore, cacheMissRatio(indices));
+    return line;
+}
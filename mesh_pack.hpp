@@ -0,0 +1,58 @@
+#ifndef MESH_PACK_H
+#define MESH_PACK_H
+
+#include <GL/glew.h>
+#include <vector>
+#include <string>
+#include <glm/glm.hpp>
+#include "frame_arena.hpp"
+
+/*
+ 8-byte mesh vertex: position as 3 normalized shorts relative to the mesh bounds, normal
+ octahedral-encoded in 2 normalized bytes. The vertex shader restores the position with
+ pos_offset + pos_scale * vp; the normal is decoded with
+     n = vec3(e, 1 - |e.x| - |e.y|); if (n.z < 0) n.xy = (1 - |n.yx|) * signNotZero(n.xy); normalize(n)
+ (octDecode in the main shaders), which light with it.
+*/
+struct PackedVertex
+{
+    GLshort position[3];
+    GLbyte normal[2];
+};
+
+// where a mesh's vertex attributes and decode uniforms live in the program drawing it
+struct VertexLayout
+{
+    GLuint position;
+    GLint normal;       // -1 if the program doesn't read normals
+    GLint posScale;
+    GLint posOffset;
+};
+
+// world position = offset + scale * decoded position
+struct MeshBounds
+{
+    glm::vec3 offset;
+    glm::vec3 scale;
+};
+
+// positions and normals as flat xyz floats; normals may be empty
+MeshBounds packVertices(const ArenaVector<GLfloat> &positions, const ArenaVector<GLfloat> &normals,
+    ArenaVector<PackedVertex> &packed);
+void octEncode(const glm::vec3 &n, GLbyte encoded[2]);
+
+// reorders triangles for the post-transform vertex cache (Forsyth's linear-speed method)
+void optimizeVertexCache(ArenaVector<GLuint> &indices, int vertexCount);
+// average cache miss ratio: vertices transformed per triangle with a FIFO cache of cacheSize
+float cacheMissRatio(const ArenaVector<GLuint> &indices, int cacheSize = 16);
+
+// uploads the packed vertices and the indices (as GLushort when they fit) into the bound VAO,
+// sets up the attributes and returns the index type for glDrawElements
+GLenum uploadMesh(const VertexLayout &layout, const ArenaVector<PackedVertex> &vertices,
+    const ArenaVector<GLuint> &indices, GLuint &vboVertex, GLuint &vboIndex);
+void setMeshBounds(const VertexLayout &layout, const MeshBounds &bounds);
+
+// one line for the mesh log: packed vs float bytes, index size and cache miss ratio
+std::string meshStats(int vertexCount, const ArenaVector<GLuint> &indices, float missRatioBefore);
+
+#endif // MESH_PACK_H
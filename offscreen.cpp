@@ -0,0 +1,134 @@
+#include "offscreen.hpp"
+#include "frame_writer.hpp"
+
+#include <iostream>
+
+OffscreenTarget::OffscreenTarget()
+{
+    isInited = false;
+    width = 0;
+    height = 0;
+    fbo = 0;
+    rboColor = 0;
+    rboDepth = 0;
+    pbo[0] = 0;
+    pbo[1] = 0;
+    current = 0;
+    hasPrevious = false;
+}
+
+OffscreenTarget::~OffscreenTarget()
+{
+
+}
+
+bool OffscreenTarget::init(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+
+    glGenRenderbuffers(1, &rboColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, rboColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &rboDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rboColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenBuffers(2, pbo);
+    for (int i = 0; i < 2; i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    current = 0;
+    hasPrevious = false;
+    isInited = true;
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "offscreen framebuffer incomplete: 0x" << std::hex << status << std::dec << std::endl;
+        cleanup();
+        return false;
+    }
+    return true;
+}
+
+void OffscreenTarget::cleanup()
+{
+    if (!isInited) {
+        return;
+    }
+    if (pbo[0]) {
+        glDeleteBuffers(2, pbo);
+    }
+    if (fbo) {
+        glDeleteFramebuffers(1, &fbo);
+    }
+    if (rboColor) {
+        glDeleteRenderbuffers(1, &rboColor);
+    }
+    if (rboDepth) {
+        glDeleteRenderbuffers(1, &rboDepth);
+    }
+
+    isInited = false;
+    fbo = 0;
+    rboColor = 0;
+    rboDepth = 0;
+    pbo[0] = 0;
+    pbo[1] = 0;
+}
+
+void OffscreenTarget::bind()
+{
+    if (!isInited) {
+        std::cout << "please call init() before bind()" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+}
+
+void OffscreenTarget::readback(FrameWriter &writer)
+{
+    // start the copy of this frame; with a pack buffer bound glReadPixels returns right away
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[current]);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // the previous frame's copy had a whole frame to finish
+    if (hasPrevious) {
+        deliver(1 - current, writer);
+    }
+    hasPrevious = true;
+    current = 1 - current;
+}
+
+void OffscreenTarget::finish(FrameWriter &writer)
+{
+    if (hasPrevious) {
+        deliver(1 - current, writer);
+        hasPrevious = false;
+    }
+}
+
+void OffscreenTarget::deliver(int index, FrameWriter &writer)
+{
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[index]);
+    const unsigned char *pixels = (const unsigned char *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, width * height * 4, GL_MAP_READ_BIT);
+    if (pixels) {
+        writer.push(pixels);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
@@ -0,0 +1,32 @@
+#ifndef OFFSCREEN_H
+#define OFFSCREEN_H
+
+#include <GL/glew.h>
+
+class FrameWriter;
+
+// framebuffer object to render into when there is no window to show, with two pixel
+// pack buffers so the readback of frame N overlaps with drawing frame N+1
+class OffscreenTarget
+{
+public:
+    OffscreenTarget();
+    ~OffscreenTarget();
+    bool init(int width, int height);
+    void cleanup();
+    void bind();                        // draw into the offscreen target
+    void readback(FrameWriter &writer); // queue this frame, hand the previous one to the writer
+    void finish(FrameWriter &writer);   // hand over the last frame still in flight
+
+private:
+    bool isInited;
+    int width, height;
+    GLuint fbo, rboColor, rboDepth;
+    GLuint pbo[2];
+    int current;        // pbo being filled this frame
+    bool hasPrevious;   // the other pbo holds a frame nobody has read yet
+
+    void deliver(int index, FrameWriter &writer);
+};
+
+#endif // OFFSCREEN_H
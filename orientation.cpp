@@ -0,0 +1,138 @@
+#include "orientation.hpp"
+#include "world.hpp"
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define ORIENTATION_SSE
+#endif
+
+// one body, also the tail of the SSE loops
+static inline void integrateOne(glm::quat &q, const glm::vec3 &w, float h)
+{
+    float qx = q.x + h * (q.w * w.x + w.y * q.z - w.z * q.y);
+    float qy = q.y + h * (q.w * w.y + w.z * q.x - w.x * q.z);
+    float qz = q.z + h * (q.w * w.z + w.x * q.y - w.y * q.x);
+    float qw = q.w - h * (w.x * q.x + w.y * q.y + w.z * q.z);
+    float inv = 1.0f / std::sqrt(qx * qx + qy * qy + qz * qz + qw * qw);
+    q.x = qx * inv; q.y = qy * inv; q.z = qz * inv; q.w = qw * inv;
+}
+
+static inline void packOne(const glm::quat &q, const glm::vec3 &x, float *out)
+{
+    out[0] = 1.0f - 2.0f * (q.y * q.y + q.z * q.z);
+    out[1] = 2.0f * (q.x * q.y - q.w * q.z);
+    out[2] = 2.0f * (q.x * q.z + q.w * q.y);
+    out[3] = x.x;
+    out[4] = 2.0f * (q.x * q.y + q.w * q.z);
+    out[5] = 1.0f - 2.0f * (q.x * q.x + q.z * q.z);
+    out[6] = 2.0f * (q.y * q.z - q.w * q.x);
+    out[7] = x.y;
+    out[8] = 2.0f * (q.x * q.z - q.w * q.y);
+    out[9] = 2.0f * (q.y * q.z + q.w * q.x);
+    out[10] = 1.0f - 2.0f * (q.x * q.x + q.y * q.y);
+    out[11] = x.z;
+}
+
+#ifdef ORIENTATION_SSE
+static_assert(offsetof(glm::quat, x) == 0 && offsetof(glm::quat, w) == 12, "quaternion stored as x, y, z, w");
+#endif
+
+void integrateOrientations(Bodies &bodies, float DT)
+{
+    const int n = bodies.size();
+    glm::quat *q = bodies.orientation.data();
+    const glm::vec3 *w = bodies.angularVelocity.data();
+    const float h = 0.5f * DT;
+    int i = 0;
+
+#ifdef ORIENTATION_SSE
+    const __m128 H = _mm_set1_ps(h);
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; i + 4 <= n; i += 4) {
+        // four quaternions transposed into x, y, z, w lanes
+        __m128 qx = _mm_loadu_ps(&q[i].x);
+        __m128 qy = _mm_loadu_ps(&q[i + 1].x);
+        __m128 qz = _mm_loadu_ps(&q[i + 2].x);
+        __m128 qw = _mm_loadu_ps(&q[i + 3].x);
+        _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+        __m128 wx = _mm_setr_ps(w[i].x, w[i + 1].x, w[i + 2].x, w[i + 3].x);
+        __m128 wy = _mm_setr_ps(w[i].y, w[i + 1].y, w[i + 2].y, w[i + 3].y);
+        __m128 wz = _mm_setr_ps(w[i].z, w[i + 1].z, w[i + 2].z, w[i + 3].z);
+
+        __m128 nx = _mm_add_ps(qx, _mm_mul_ps(H, _mm_sub_ps(_mm_add_ps(_mm_mul_ps(qw, wx), _mm_mul_ps(wy, qz)), _mm_mul_ps(wz, qy))));
+        __m128 ny = _mm_add_ps(qy, _mm_mul_ps(H, _mm_sub_ps(_mm_add_ps(_mm_mul_ps(qw, wy), _mm_mul_ps(wz, qx)), _mm_mul_ps(wx, qz))));
+        __m128 nz = _mm_add_ps(qz, _mm_mul_ps(H, _mm_sub_ps(_mm_add_ps(_mm_mul_ps(qw, wz), _mm_mul_ps(wx, qy)), _mm_mul_ps(wy, qx))));
+        __m128 nw = _mm_sub_ps(qw, _mm_mul_ps(H, _mm_add_ps(_mm_add_ps(_mm_mul_ps(wx, qx), _mm_mul_ps(wy, qy)), _mm_mul_ps(wz, qz))));
+        __m128 norm = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_add_ps(_mm_mul_ps(nz, nz), _mm_mul_ps(nw, nw)));
+        __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(norm));
+        qx = _mm_mul_ps(nx, inv);
+        qy = _mm_mul_ps(ny, inv);
+        qz = _mm_mul_ps(nz, inv);
+        qw = _mm_mul_ps(nw, inv);
+
+        // back to one quaternion per body
+        _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+        _mm_storeu_ps(&q[i].x, qx);
+        _mm_storeu_ps(&q[i + 1].x, qy);
+        _mm_storeu_ps(&q[i + 2].x, qz);
+        _mm_storeu_ps(&q[i + 3].x, qw);
+    }
+#endif
+
+    for (; i < n; i++) {
+        integrateOne(q[i], w[i], h);
+    }
+}
+
+void packTransforms(const Bodies &bodies, float *transforms)
+{
+    const int n = bodies.size();
+    const glm::quat *q = bodies.orientation.data();
+    const glm::vec3 *x = bodies.position.data();
+    int i = 0;
+
+#ifdef ORIENTATION_SSE
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    for (; i + 4 <= n; i += 4) {
+        __m128 qx = _mm_loadu_ps(&q[i].x);
+        __m128 qy = _mm_loadu_ps(&q[i + 1].x);
+        __m128 qz = _mm_loadu_ps(&q[i + 2].x);
+        __m128 qw = _mm_loadu_ps(&q[i + 3].x);
+        _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+        __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+        __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+        __m128 wqx = _mm_mul_ps(qw, qx), wqy = _mm_mul_ps(qw, qy), wqz = _mm_mul_ps(qw, qz);
+        __m128 r00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+        __m128 r01 = _mm_mul_ps(two, _mm_sub_ps(xy, wqz));
+        __m128 r02 = _mm_mul_ps(two, _mm_add_ps(xz, wqy));
+        __m128 r10 = _mm_mul_ps(two, _mm_add_ps(xy, wqz));
+        __m128 r11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+        __m128 r12 = _mm_mul_ps(two, _mm_sub_ps(yz, wqx));
+        __m128 r20 = _mm_mul_ps(two, _mm_sub_ps(xz, wqy));
+        __m128 r21 = _mm_mul_ps(two, _mm_add_ps(yz, wqx));
+        __m128 r22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+        __m128 tx = _mm_setr_ps(x[i].x, x[i + 1].x, x[i + 2].x, x[i + 3].x);
+        __m128 ty = _mm_setr_ps(x[i].y, x[i + 1].y, x[i + 2].y, x[i + 3].y);
+        __m128 tz = _mm_setr_ps(x[i].z, x[i + 1].z, x[i + 2].z, x[i + 3].z);
+
+        // each matrix row is (r0, r1, r2, t) of one body: transpose lanes into rows
+        float *out = transforms + i * transformFloats;
+        _MM_TRANSPOSE4_PS(r00, r01, r02, tx);
+        _MM_TRANSPOSE4_PS(r10, r11, r12, ty);
+        _MM_TRANSPOSE4_PS(r20, r21, r22, tz);
+        _mm_storeu_ps(out + 0, r00);  _mm_storeu_ps(out + 4, r10);  _mm_storeu_ps(out + 8, r20);
+        _mm_storeu_ps(out + 12, r01); _mm_storeu_ps(out + 16, r11); _mm_storeu_ps(out + 20, r21);
+        _mm_storeu_ps(out + 24, r02); _mm_storeu_ps(out + 28, r12); _mm_storeu_ps(out + 32, r22);
+        _mm_storeu_ps(out + 36, tx);  _mm_storeu_ps(out + 40, ty);  _mm_storeu_ps(out + 44, tz);
+    }
+#endif
+
+    for (; i < n; i++) {
+        packOne(q[i], x[i], transforms + i * transformFloats);
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef ORIENTATION_H
+#define ORIENTATION_H
+
+struct Bodies;
+
+// floats per body in the instance buffer: a 3x4 row-major transform, rotation | position
+const int transformFloats = 12;
+
+// advances every body's orientation by its angular velocity over DT (q += DT/2 * w * q,
+// renormalized). Part of every World step; four bodies at a time with SSE where available.
+void integrateOrientations(Bodies &bodies, float DT);
+
+// writes each body's current transform to transforms[slot * transformFloats], which can
+// point straight into a mapped GL buffer. Reads the state only, so drawing never advances it.
+void packTransforms(const Bodies &bodies, float *transforms);
+
+#endif // ORIENTATION_H
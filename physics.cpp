@@ -0,0 +1,250 @@
+#include "physics.hpp"
+
+#include <cmath>
+
+static ForceModel forceModel = uniformGravity;
+
+glm::vec3 uniformGravity(const glm::vec3 &position, float mass){
+	return glm::vec3(0.0f, 0.0f, -mass*gravity);
+}
+
+glm::vec3 noForce(const glm::vec3 &position, float mass){
+	return glm::vec3(0.0f, 0.0f, 0.0f);
+}
+
+void setForceModel(ForceModel model){
+	forceModel = model;
+}
+
+glm::vec3 accelerationAt(const glm::vec3 &position, float mass){
+	return forceModel(position, mass)/mass;
+}
+
+void updateAcceleration (Sphere &sphere){
+	sphere.setAcceleration(accelerationAt(sphere.getPosition(), sphere.getMass()));
+}
+
+void IntegrateEuler(Sphere &sphere, float DT){
+		sphere.setVelocity(sphere.getAcceleration()*DT + sphere.getVelocity());
+		sphere.setPosition(sphere.getVelocity()*DT + sphere.getPosition());
+		updateAcceleration(sphere);
+}
+
+void IntegrateRK4(Sphere &bola, float DT)
+{
+	glm::vec3 Pos;
+	glm::vec3 Vel;
+
+	glm::vec3 Kv1,Kv2,Kv3,Kv4; //Son aceleraciones
+	glm::vec3 Kx1,Kx2,Kx3,Kx4; //Son velocidades
+	glm::vec3 xK2,xK3,xK4; //Son las posiciones estimadas para evaluar la aceleracion
+
+	Kv1 = bola.getAcceleration();
+	Kx1 = bola.getVelocity();
+
+	xK2 = bola.getPosition() + Kx1*DT/2.0f;
+	Kv2 = accelerationAt(xK2, bola.getMass());
+	Kx2 = bola.getVelocity() + Kv1 * DT/2.0f;
+
+	xK3 = bola.getPosition() + Kx2*DT/2.0f;
+	Kv3 = accelerationAt(xK3, bola.getMass());
+	Kx3 = bola.getVelocity() + Kv2 * DT/2.0f;
+
+	xK4 = bola.getPosition() + Kx3*DT;
+	Kv4 = accelerationAt(xK4, bola.getMass());
+	Kx4 = bola.getVelocity() + Kv3 * DT;
+
+    Vel = bola.getVelocity() + (Kv1+Kv2*2.0f+Kv3*2.0f+Kv4)/6.0f*DT;
+    Pos = bola.getPosition() + (Kx1+Kx2*2.0f+Kx3*2.0f+Kx4)/6.0f*DT;
+
+	bola.setVelocity(Vel); // Update object's velocity
+	bola.setPosition(Pos); // Update object's position
+	updateAcceleration(bola);
+}
+
+void IntegrateVerlet (Sphere &sphere, float DT){
+        sphere.setPosition(sphere.getPosition() + sphere.getVelocity()*DT + 1.0f/2.0f*sphere.getAcceleration()*DT*DT);
+        glm::vec3 oldAcceleration=sphere.getAcceleration();
+        updateAcceleration(sphere);
+        sphere.setVelocity(sphere.getVelocity() + 1.0f/2.0f*(oldAcceleration*DT+sphere.getAcceleration()*DT));
+}
+
+void CheckBC(Sphere &sphere) {
+	if (sphere.getPosition().z <= R){
+			glm::vec3 oldVelocity;
+			glm::vec3 newVelocity;
+			oldVelocity = sphere.getVelocity();
+			newVelocity = oldVelocity;
+			newVelocity.z = -oldVelocity.z;
+			sphere.setVelocity(newVelocity);
+
+			glm::vec3 oldPosition;
+			glm::vec3 newPosition;
+			oldPosition = sphere.getPosition();
+			newPosition = oldPosition;
+			newPosition.z = R;
+			sphere.setPosition(newPosition);
+			
+		}
+
+		if (sphere.getPosition().x <= -2+R){
+			glm::vec3 oldVelocity;
+			glm::vec3 newVelocity;
+			oldVelocity = sphere.getVelocity();
+			newVelocity = oldVelocity;
+			newVelocity.x = -oldVelocity.x;
+			sphere.setVelocity(newVelocity);
+
+			glm::vec3 oldPosition;
+			glm::vec3 newPosition;
+			oldPosition = sphere.getPosition();
+			newPosition = oldPosition;
+			newPosition.x = -2+R;
+			sphere.setPosition(newPosition);
+			
+		}
+
+		if (sphere.getPosition().x >= 2-R){
+			glm::vec3 oldVelocity;
+			glm::vec3 newVelocity;
+			oldVelocity = sphere.getVelocity();
+			newVelocity = oldVelocity;
+			newVelocity.x = -oldVelocity.x;
+			sphere.setVelocity(newVelocity);
+
+			glm::vec3 oldPosition;
+			glm::vec3 newPosition;
+			oldPosition = sphere.getPosition();
+			newPosition = oldPosition;
+			newPosition.x = 2-R;
+			sphere.setPosition(newPosition);
+			
+		}
+
+		if (sphere.getPosition().y <= -2+R){
+			glm::vec3 oldVelocity;
+			glm::vec3 newVelocity;
+			oldVelocity = sphere.getVelocity();
+			newVelocity = oldVelocity;
+			newVelocity.y = -oldVelocity.y;
+			sphere.setVelocity(newVelocity);
+
+			glm::vec3 oldPosition;
+			glm::vec3 newPosition;
+			oldPosition = sphere.getPosition();
+			newPosition = oldPosition;
+			newPosition.y = -2+R;
+			sphere.setPosition(newPosition);
+			
+		}
+
+		if (sphere.getPosition().y >= 2-R){
+			glm::vec3 oldVelocity;
+			glm::vec3 newVelocity;
+			oldVelocity = sphere.getVelocity();
+			newVelocity = oldVelocity;
+			newVelocity.y = -oldVelocity.y;
+			sphere.setVelocity(newVelocity);
+
+			glm::vec3 oldPosition;
+			glm::vec3 newPosition;
+			oldPosition = sphere.getPosition();
+			newPosition = oldPosition;
+			newPosition.y = 2-R;
+			sphere.setPosition(newPosition);
+			
+		}
+		
+}
+
+bool SphereContact (const glm::vec3 &oldPosition1, glm::vec3 &velocity1, float m1,
+	const glm::vec3 &oldPosition2, glm::vec3 &velocity2, float m2){
+	glm::vec3 separation = oldPosition1 - oldPosition2;
+	glm::vec3 approach = velocity1 - velocity2;
+	// only resolve while closing in, otherwise overlapping spheres flip back and forth and stick
+	if (glm::length(separation) <= 2*R && glm::dot(separation, approach) < 0.0f){
+			glm::vec3 oldVelocity1 = velocity1;
+			glm::vec3 oldVelocity2 = velocity2;
+
+			/*newVelocity1 = oldVelocity1 + 
+			     glm::length(oldPosition2 - oldPosition1)*
+				 glm::dot(oldVelocity2,(oldPosition2 - oldPosition1))/
+				 glm::dot((oldPosition2 - oldPosition1),(oldPosition2 - oldPosition1)) -
+				 glm::length(oldPosition1 - oldPosition2)*
+				 glm::dot(oldVelocity1,(oldPosition1 - oldPosition2))/
+				 glm::dot((oldPosition1 - oldPosition2),(oldPosition1 - oldPosition2));
+
+			newVelocity2 = oldVelocity2 + 
+			     glm::length(oldPosition2 - oldPosition1)*
+				 glm::dot(oldVelocity1,(oldPosition2 - oldPosition1))/
+				 glm::dot((oldPosition2 - oldPosition1),(oldPosition2 - oldPosition1)) -
+				 glm::length(oldPosition1 - oldPosition2)*
+				 glm::dot(oldVelocity2,(oldPosition1 - oldPosition2))/
+				 glm::dot((oldPosition1 - oldPosition2),(oldPosition1 - oldPosition2));*/
+
+			glm::vec3 vecx = oldPosition1 - oldPosition2;
+			vecx = glm::normalize(vecx);
+			float x1 = glm::dot(vecx,oldVelocity1);
+			glm::vec3 vecv1x = vecx * x1;
+			glm::vec3 vecv1y = oldVelocity1 - vecv1x;
+
+			vecx = -vecx;
+			float x2 = glm::dot(vecx,oldVelocity2);
+			glm::vec3 vecv2x = vecx * x2;
+			glm::vec3 vecv2y = oldVelocity2 - vecv2x;
+
+			velocity1 = vecv1x*(m1-m2)/(m1+m2)+vecv2x*(2*m2)/(m1+m2) + vecv1y;
+			velocity2 = vecv1x*(2*m1)/(m1+m2)+vecv2x*(m2-m1)/(m1+m2) + vecv2y;
+			return true;
+		}
+	return false;
+}
+
+void SphereCollision (Sphere &sph1, Sphere &sph2){
+	glm::vec3 velocity1 = sph1.getVelocity();
+	glm::vec3 velocity2 = sph2.getVelocity();
+	if (SphereContact(sph1.getPosition(), velocity1, sph1.getMass(), sph2.getPosition(), velocity2, sph2.getMass())){
+		sph1.setVelocity(velocity1);
+		sph2.setVelocity(velocity2);
+	}
+}
+
+bool SphereContactFriction (const glm::vec3 &oldPosition1, glm::vec3 &velocity1, glm::vec3 &spin1, float m1,
+	const glm::vec3 &oldPosition2, glm::vec3 &velocity2, glm::vec3 &spin2, float m2){
+	glm::vec3 oldVelocity1 = velocity1;
+	if (!SphereContact(oldPosition1, velocity1, m1, oldPosition2, velocity2, m2)){
+		return false;
+	}
+	// normal impulse the elastic exchange just applied, it bounds the friction impulse
+	glm::vec3 n = glm::normalize(oldPosition2 - oldPosition1);
+	float normalImpulse = m1 * std::fabs(glm::dot(velocity1 - oldVelocity1, n));
+
+	// contact point halfway between the centres (they may overlap a little), so both
+	// spheres push on the same point and angular momentum is conserved
+	glm::vec3 r = 0.5f * (oldPosition2 - oldPosition1);
+	float r2 = glm::dot(r, r);
+
+	// sliding velocity of 1 against 2 at the contact point, tangential part only
+	glm::vec3 contact1 = velocity1 + glm::cross(spin1, r);
+	glm::vec3 contact2 = velocity2 + glm::cross(spin2, -r);
+	glm::vec3 slip = contact1 - contact2;
+	slip = slip - glm::dot(slip, n) * n;
+	float slipSpeed = glm::length(slip);
+	if (slipSpeed < 1e-6f){
+		return true;
+	}
+	glm::vec3 t = slip / slipSpeed;
+
+	// impulse that would stop the sliding, capped by the friction cone
+	float I1 = 2.0f / 5.0f * m1 * R * R;
+	float I2 = 2.0f / 5.0f * m2 * R * R;
+	float k = 1.0f / m1 + 1.0f / m2 + r2 / I1 + r2 / I2;
+	float impulse = std::fmin(slipSpeed / k, friction * normalImpulse);
+
+	glm::vec3 J = -impulse * t;     // on sphere 1, sphere 2 gets -J
+	velocity1 += J / m1;
+	velocity2 -= J / m2;
+	spin1 += glm::cross(r, J) / I1;
+	spin2 += glm::cross(-r, -J) / I2;
+	return true;
+}
@@ -0,0 +1,33 @@
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include <glm/glm.hpp>
+#include "sphere.hpp"
+
+const float gravity = 9.80665f;
+const float R = 0.5f;
+const float friction = 0.3f;   // Coulomb coefficient between spheres
+
+/* force on a body of the given mass at the given position */
+typedef glm::vec3 (*ForceModel)(const glm::vec3 &position, float mass);
+
+glm::vec3 uniformGravity(const glm::vec3 &position, float mass);
+glm::vec3 noForce(const glm::vec3 &position, float mass);
+void setForceModel(ForceModel model); // uniformGravity by default
+glm::vec3 accelerationAt(const glm::vec3 &position, float mass);
+
+void updateAcceleration(Sphere &sphere);
+void IntegrateEuler(Sphere &sphere, float DT);
+void IntegrateRK4(Sphere &bola, float DT);
+void IntegrateVerlet(Sphere &sphere, float DT);
+void CheckBC(Sphere &sphere);
+// elastic contact between two spheres of radius R; updates the velocities, true if they touched
+bool SphereContact(const glm::vec3 &oldPosition1, glm::vec3 &velocity1, float m1,
+	const glm::vec3 &oldPosition2, glm::vec3 &velocity2, float m2);
+// SphereContact plus sliding friction at the contact point, which spins both spheres
+// (solid spheres, I = 2/5 m R^2) and takes the tangential impulse out of their velocities
+bool SphereContactFriction(const glm::vec3 &oldPosition1, glm::vec3 &velocity1, glm::vec3 &spin1, float m1,
+	const glm::vec3 &oldPosition2, glm::vec3 &velocity2, glm::vec3 &spin2, float m2);
+void SphereCollision(Sphere &sph1, Sphere &sph2);
+
+#endif // PHYSICS_H
@@ -23,11 +23,13 @@ Plane::~Plane()
 
 }
 
-void Plane::init(GLuint vertexPositionID, float z0)
+void Plane::init(const VertexLayout &layout, float z0)
 {
     int i, j,k;
-    std::vector<GLfloat> vertices;
-    std::vector<GLuint> indices;
+    const int vertexCount = (2 * divsx + 1) * (2 * divsy + 1);
+    ArenaVector<GLfloat> vertices = arenaVector<GLfloat>(3 * vertexCount);
+    ArenaVector<GLuint> indices = arenaVector<GLuint>(6 * 4 * divsx * divsy);
+    ArenaVector<GLfloat> normals = arenaVector<GLfloat>(3 * vertexCount);
     
     for(i = -divsx; i <= divsx; ++i) {
        
@@ -38,6 +40,9 @@ void Plane::init(GLuint vertexPositionID, float z0)
            vertices.push_back(x);
            vertices.push_back(y);
            vertices.push_back(z);
+           normals.push_back(0.0f);
+           normals.push_back(0.0f);
+           normals.push_back(1.0f);
            
         }
     }
@@ -62,20 +67,15 @@ void Plane::init(GLuint vertexPositionID, float z0)
         }
     }
 
+    ArenaVector<PackedVertex> packed = arenaVector<PackedVertex>(vertexCount);
+    bounds = packVertices(vertices, normals, packed);
+    float missRatio = cacheMissRatio(indices);
+    optimizeVertexCache(indices, packed.size());
+    this->layout = layout;
+
     glGenVertexArrays(1, &plane_vao);
     glBindVertexArray(plane_vao);
-
-    glGenBuffers(1, &plane_vboVertex);
-    glBindBuffer(GL_ARRAY_BUFFER, plane_vboVertex);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), &vertices[0], GL_STATIC_DRAW);
-
-    glVertexAttribPointer(vertexPositionID, 3, GL_FLOAT, GL_FALSE, 0, NULL);
-    glEnableVertexAttribArray (vertexPositionID);
-
-    glGenBuffers(1, &plane_vboIndex);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, plane_vboIndex);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
-
+    indexType = uploadMesh(layout, packed, indices, plane_vboVertex, plane_vboIndex);
     glBindVertexArray(0);
 
     numsToDraw = indices.size();
@@ -84,6 +84,7 @@ void Plane::init(GLuint vertexPositionID, float z0)
     plane_vertex_log_file.open("plane_v.log");
 	int v_number = 0;
     plane_vertex_log_file << "vertices.size(): " << vertices.size() << std::endl;
+    plane_vertex_log_file << meshStats(packed.size(), indices, missRatio) << std::endl;
     for (k = 0;k<vertices.size();k=k+3){
         plane_vertex_log_file << " Vertex[" << v_number << "]: " << vertices[k] << "   " << vertices[k+1] << "   " << vertices[k+2] << std::endl ;
         v_number++;
@@ -131,5 +132,6 @@ void Plane::draw()
     // draw plane
     glPolygonMode(GL_FRONT_AND_BACK,GL_LINE);
     glBindVertexArray(plane_vao);
-    glDrawElements(GL_TRIANGLES, numsToDraw, GL_UNSIGNED_INT, NULL);
+    setMeshBounds(layout, bounds);
+    glDrawElements(GL_TRIANGLES, numsToDraw, indexType, NULL);
 }
\ No newline at end of file
@@ -2,13 +2,14 @@
 #define PLANE_H
 
 #include <GL/glew.h>
+#include "mesh_pack.hpp"
 
 class Plane
 {
 public:
     Plane();
     ~Plane();
-    void init(GLuint vertexPositionID, float z0);
+    void init(const VertexLayout &layout, float z0);
     void cleanup();
     void draw();
 
@@ -17,6 +18,9 @@ private:
     bool isInited;
     GLuint plane_vao, plane_vboVertex, plane_vboIndex;
     int numsToDraw;
+    GLenum indexType;
+    VertexLayout layout;
+    MeshBounds bounds;
 };
 
 #endif // SPHERE_H
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "profiler.hpp"
+
+#ifdef ENABLE_PROFILER
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PROFILER_HAS_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_HAS_TSC
+#endif
+
+struct ZoneEvent
+{
+    const char *name;
+    uint64_t start, end;
+};
+
+// zones kept per thread; once full, later zones are dropped and counted rather than
+// growing the buffer on the recording path
+static const uint32_t zoneCapacity = 1 << 16;
+
+/* one per thread, only ever written by its owner so recording needs no lock. Slots below
+   count are never written again, and count is published with release after the slot, so
+   profilerWrite can read them while the owner keeps recording. */
+struct ThreadBuffer
+{
+    int tid;
+    std::atomic<const char *> name;
+    std::unique_ptr<ZoneEvent[]> events;
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> dropped;
+};
+
+// buffers are owned here so zones survive their thread exiting
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+static inline uint64_t readTicks()
+{
+#ifdef PROFILER_HAS_TSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// reference point taken at startup, the tick rate is measured against it when writing
+static const uint64_t ticksAtStart = readTicks();
+static const std::chrono::steady_clock::time_point clockAtStart = std::chrono::steady_clock::now();
+
+static ThreadBuffer *threadBuffer()
+{
+    thread_local ThreadBuffer *buffer = NULL;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.emplace_back(new ThreadBuffer());
+        buffer = registry.back().get();
+        buffer->tid = (int)registry.size();
+        buffer->name.store(NULL);
+        buffer->events.reset(new ZoneEvent[zoneCapacity]);
+        buffer->count.store(0);
+        buffer->dropped.store(0);
+    }
+    return buffer;
+}
+
+ProfileZone::ProfileZone(const char *name)
+{
+    this->name = name;
+    start = readTicks();
+}
+
+ProfileZone::~ProfileZone()
+{
+    uint64_t end = readTicks();
+    ThreadBuffer *buffer = threadBuffer();
+    uint32_t n = buffer->count.load(std::memory_order_relaxed);
+    if (n == zoneCapacity) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[n] = {name, start, end};
+    buffer->count.store(n + 1, std::memory_order_release);
+}
+
+void profilerSetThreadName(const char *name)
+{
+    threadBuffer()->name.store(name, std::memory_order_release);
+}
+
+bool profilerWrite(const char *path)
+{
+    uint64_t ticksNow = readTicks();
+    double elapsedUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - clockAtStart).count();
+    double ticksPerUs = elapsedUs > 0.0 ? (ticksNow - ticksAtStart) / elapsedUs : 1.0;
+
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    file << std::fixed << std::setprecision(3); // microseconds, keep ns resolution on long runs
+    file << "{\"traceEvents\":[";
+    bool first = true;
+    for (const std::unique_ptr<ThreadBuffer> &buffer : registry) {
+        const char *name = buffer->name.load(std::memory_order_acquire);
+        if (name) {
+            file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+                 << ",\"args\":{\"name\":\"" << name << "\"}}";
+            first = false;
+        }
+        // only the zones published so far; the owner may still be recording
+        uint32_t count = buffer->count.load(std::memory_order_acquire);
+        uint32_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+        if (dropped) {
+            file << (first ? "" : ",") << "\n{\"name\":\"profiler_dropped\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+                 << ",\"args\":{\"zones\":" << dropped << "}}";
+            first = false;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            const ZoneEvent &event = buffer->events[i];
+            file << (first ? "" : ",") << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                 << ",\"ts\":" << (event.start - ticksAtStart) / ticksPerUs
+                 << ",\"dur\":" << (event.end - event.start) / ticksPerUs << "}";
+            first = false;
+        }
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return true;
+}
+
+#endif // ENABLE_PROFILER
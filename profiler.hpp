@@ -0,0 +1,46 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/*
+ scoped timing zones written out as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev)
+
+ build with -DENABLE_PROFILER to turn it on, otherwise every macro below expands to nothing.
+
+     PROFILE_ZONE("collision");      // times the rest of the enclosing scope
+     PROFILE_THREAD_NAME("physics");  // label for the calling thread in the trace
+     PROFILE_WRITE("profile.json");   // dump every thread's zones
+*/
+
+#ifdef ENABLE_PROFILER
+
+#include <cstdint>
+
+class ProfileZone
+{
+public:
+    ProfileZone(const char *name);
+    ~ProfileZone();
+
+private:
+    const char *name;
+    uint64_t start;
+};
+
+void profilerSetThreadName(const char *name);
+bool profilerWrite(const char *path);
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) profilerSetThreadName(name)
+#define PROFILE_WRITE(path) profilerWrite(path)
+
+#else
+
+#define PROFILE_ZONE(name)
+#define PROFILE_THREAD_NAME(name)
+#define PROFILE_WRITE(path)
+
+#endif // ENABLE_PROFILER
+
+#endif // PROFILER_H
@@ -0,0 +1,242 @@
+#include "shader_cache.hpp"
+
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+// FNV-1a, 64 bit; the strings are hashed with their terminators so "ab"+"c" != "a"+"bc"
+static uint64_t hashString(uint64_t hash, const char *text)
+{
+    do {
+        hash ^= (unsigned char)*text;
+        hash *= 0x100000001b3ull;
+    } while (*text++);
+    return hash;
+}
+
+ProgramCache::ProgramCache()
+{
+    isInited = false;
+    binariesSupported = false;
+    hits = 0;
+    misses = 0;
+}
+
+void ProgramCache::init(const std::string &directory, const std::string &logPath)
+{
+    this->directory = directory;
+    this->logPath = logPath;
+    const GLubyte *renderer = glGetString(GL_RENDERER);
+    const GLubyte *version = glGetString(GL_VERSION);
+    driver = std::string(renderer ? (const char *)renderer : "") + "\n" + (version ? (const char *)version : "");
+
+    // a driver may support GL_ARB_get_program_binary but list no formats, then there is nothing to store
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    binariesSupported = formats > 0;
+    if (binariesSupported) {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error) {
+            log("program cache: can't create " + directory + ": " + error.message());
+            binariesSupported = false;
+        }
+    } else {
+        log("program cache: driver offers no program binary formats, compiling every launch");
+    }
+    isInited = true;
+}
+
+GLuint ProgramCache::build(const char *vertexSource, const char *fragmentSource)
+{
+    if (!isInited) {
+        std::cout << "please call init() before build()" << std::endl;
+        return 0;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    uint64_t key = 0xcbf29ce484222325ull;
+    key = hashString(key, vertexSource);
+    key = hashString(key, fragmentSource);
+    key = hashString(key, driver.c_str());
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    std::string path = directory + "/" + name;
+
+    GLuint program = binariesSupported ? load(path) : 0;
+    bool cached = program != 0;
+    if (!program) {
+        GLuint vs = compile(GL_VERTEX_SHADER, vertexSource);
+        GLuint fs = compile(GL_FRAGMENT_SHADER, fragmentSource);
+        if (vs && fs) {
+            program = glCreateProgram();
+            glAttachShader(program, fs);
+            glAttachShader(program, vs);
+            if (binariesSupported) {
+                glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
+            glLinkProgram(program);
+            glDetachShader(program, fs);
+            glDetachShader(program, vs);
+            if (!checkLink(program, true)) {
+                glDeleteProgram(program);
+                program = 0;
+            } else if (binariesSupported) {
+                save(program, path);
+            }
+        }
+        glDeleteShader(vs);
+        glDeleteShader(fs);
+    }
+
+    if (cached) {
+        hits++;
+    } else {
+        misses++;
+    }
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    char message[128];
+    std::snprintf(message, sizeof(message), "program cache: %s %s in %.2f ms", name,
+        cached ? "loaded" : (program ? "compiled" : "failed"), ms);
+    log(message);
+    return program;
+}
+
+GLuint ProgramCache::load(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return 0;
+    }
+    GLenum format = 0;
+    file.read((char *)&format, sizeof(format));
+    std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::error_code error;  // a cache entry we can't delete is not worth failing startup over
+    if (binary.empty()) {
+        std::filesystem::remove(path, error);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), (GLsizei)binary.size());
+    if (!checkLink(program, false)) {
+        // stale: the driver changed under the same renderer/version strings
+        log("program cache: " + path + " rejected by the driver, recompiling");
+        glDeleteProgram(program);
+        std::filesystem::remove(path, error);
+        return 0;
+    }
+    return program;
+}
+
+void ProgramCache::save(GLuint program, const std::string &path)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, NULL, &format, binary.data());
+
+    // written aside and renamed, so a crash never leaves a truncated binary behind
+    std::string temporary = path + ".tmp";
+    std::ofstream file(temporary, std::ios::binary);
+    file.write((const char *)&format, sizeof(format));
+    file.write(binary.data(), binary.size());
+    file.close();
+    std::error_code error;
+    if (!file.good()) {
+        // short write (disk full, I/O error): never let it reach the real name
+        log("program cache: can't write " + path);
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        log("program cache: can't write " + path);
+        std::filesystem::remove(temporary, error);
+    }
+}
+
+GLuint ProgramCache::compile(GLenum type, const char *source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+        GLint length = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+        std::string info(length > 1 ? length : 1, '\0');
+        glGetShaderInfoLog(shader, info.size(), NULL, &info[0]);
+        log(std::string(type == GL_VERTEX_SHADER ? "vertex" : "fragment") + " shader failed to compile:\n" + info.c_str());
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+bool ProgramCache::checkLink(GLuint program, bool logErrors)
+{
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE && logErrors) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        std::string info(length > 1 ? length : 1, '\0');
+        glGetProgramInfoLog(program, info.size(), NULL, &info[0]);
+        log(std::string("program failed to link:\n") + info.c_str());
+    }
+    return status == GL_TRUE;
+}
+
+void ProgramCache::addWarmUp(GLuint program, const std::function<void()> &draw)
+{
+    WarmUp warmUp = {program, draw};
+    warmUps.push_back(warmUp);
+}
+
+void ProgramCache::warmUp()
+{
+    if (warmUps.empty()) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    GLint currentProgram = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+    GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+    GLint box[4];
+    glGetIntegerv(GL_SCISSOR_BOX, box);
+
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, 1, 1);
+    for (const WarmUp &warmUp : warmUps) {
+        glUseProgram(warmUp.program);
+        warmUp.draw();
+    }
+    glFinish();
+
+    glScissor(box[0], box[1], box[2], box[3]);
+    if (!scissor) {
+        glDisable(GL_SCISSOR_TEST);
+    }
+    glUseProgram(currentProgram);
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    char message[96];
+    std::snprintf(message, sizeof(message), "program cache: warmed up %d draws in %.2f ms", (int)warmUps.size(), ms);
+    log(message);
+}
+
+void ProgramCache::log(const std::string &message)
+{
+    std::ofstream file(logPath, std::ios::app);
+    file << message << std::endl;
+}
@@ -0,0 +1,48 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+// linked programs saved with glGetProgramBinary under <directory>/<key>.bin, the key being a
+// hash of the shader sources and the GL_RENDERER/GL_VERSION strings. A binary the driver
+// rejects (new driver, different GPU) is deleted and the program compiled from source again.
+// Compile and link errors go to the log file instead of being ignored.
+class ProgramCache
+{
+public:
+    ProgramCache();
+    void init(const std::string &directory, const std::string &logPath);
+    GLuint build(const char *vertexSource, const char *fragmentSource);  // 0 if it doesn't compile or link
+
+    // drivers finish compiling lazily on first use; warmUp() draws every registered
+    // program/mesh pair into a 1x1 scissor and waits for it, so the first real frame doesn't
+    // pay for that. Call once after everything is registered and before the frame loop.
+    void addWarmUp(GLuint program, const std::function<void()> &draw);
+    void warmUp();
+
+    int getHits() const { return hits; }
+    int getMisses() const { return misses; }
+
+private:
+    struct WarmUp {
+        GLuint program;
+        std::function<void()> draw;
+    };
+
+    bool isInited;
+    bool binariesSupported;
+    std::string directory, logPath, driver;
+    int hits, misses;
+    std::vector<WarmUp> warmUps;
+
+    GLuint load(const std::string &path);
+    void save(GLuint program, const std::string &path);
+    GLuint compile(GLenum type, const char *source);
+    bool checkLink(GLuint program, bool logErrors);
+    void log(const std::string &message);
+};
+
+#endif // SHADER_CACHE_H
@@ -0,0 +1,309 @@
+#include "sim_feed.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static const uint32_t feedMagic = 0x44454546;   // "FEED"
+static const uint32_t feedVersion = 2;
+static const size_t headerBytes = 64;           // frames start on their own cache line
+static_assert(sizeof(FeedHeader) <= headerBytes, "header must fit before the first frame");
+
+static size_t frameBytesFor(int maxBodies)
+{
+    size_t bytes = sizeof(FeedFrame) + maxBodies * sizeof(FeedBody);
+    return (bytes + 63) & ~(size_t)63;
+}
+
+static FeedFrame *frameAt(const FeedHeader *header, uint64_t index)
+{
+    return (FeedFrame *)((char *)header + headerBytes + (index % header->frames) * header->frameBytes);
+}
+
+static std::string shmName(const std::string &name)
+{
+    return name[0] == '/' ? name : "/" + name;
+}
+
+int64_t feedClockNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ---------------------------------------------------------------- writer
+
+SimFeedWriter::SimFeedWriter()
+{
+    header = NULL;
+    mappedBytes = 0;
+    step = 0;
+}
+
+SimFeedWriter::~SimFeedWriter()
+{
+    close();
+}
+
+#ifndef _WIN32
+
+// an existing object is stale only if it was fully set up and its writer is gone; one that is
+// half initialized or whose writer still runs is left alone
+static bool feedIsStale(const std::string &name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    bool stale = false;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size >= headerBytes) {
+        void *memory = mmap(NULL, headerBytes, PROT_READ, MAP_SHARED, fd, 0);
+        if (memory != MAP_FAILED) {
+            const FeedHeader *existing = (const FeedHeader *)memory;
+            if (existing->magic == feedMagic && existing->version == feedVersion && existing->writerPid > 0) {
+                stale = kill(existing->writerPid, 0) != 0 && errno == ESRCH;
+            }
+            munmap(memory, headerBytes);
+        }
+    }
+    ::close(fd);
+    return stale;
+}
+
+bool SimFeedWriter::open(const std::string &name, int maxBodies, int frames)
+{
+    close();
+    this->name = shmName(name);
+    mappedBytes = headerBytes + frames * frameBytesFor(maxBodies);
+
+    // never attach to another writer's object: create it exclusively, and replace an existing
+    // one only when the process that wrote it is gone
+    int fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        if (!feedIsStale(this->name)) {
+            std::cout << "shared memory " << this->name << " is in use by another writer" << std::endl;
+            return false;
+        }
+        shm_unlink(this->name.c_str());
+        fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+    if (fd < 0) {
+        std::cout << "can't create shared memory " << this->name << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    void *memory = MAP_FAILED;
+    if (ftruncate(fd, mappedBytes) == 0) {
+        memory = mmap(NULL, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        std::cout << "can't map shared memory " << this->name << ": " << strerror(errno) << std::endl;
+        shm_unlink(this->name.c_str());
+        return false;
+    }
+
+    memset(memory, 0, mappedBytes);
+    header = (FeedHeader *)memory;
+    header->version = feedVersion;
+    header->frames = frames;
+    header->maxBodies = maxBodies;
+    header->frameBytes = frameBytesFor(maxBodies);
+    header->published.store(0, std::memory_order_relaxed);
+    header->writerPid = getpid();
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = feedMagic;     // readers refuse the object until this is set
+    step = 0;
+    return true;
+}
+
+void SimFeedWriter::close()
+{
+    if (!header) {
+        return;
+    }
+    munmap(header, mappedBytes);
+    shm_unlink(name.c_str());
+    header = NULL;
+}
+
+#else
+
+bool SimFeedWriter::open(const std::string &name, int maxBodies, int frames)
+{
+    std::cout << "the shared-memory feed needs POSIX shm, not available on this platform" << std::endl;
+    return false;
+}
+
+void SimFeedWriter::close()
+{
+}
+
+#endif
+
+void SimFeedWriter::publish(const Bodies &bodies, double simTime)
+{
+    if (!header) {
+        return;
+    }
+    FeedFrame *frame = frameAt(header, step);
+    uint32_t sequence = frame->sequence.load(std::memory_order_relaxed);
+    frame->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const int count = std::min(bodies.size(), (int)header->maxBodies);
+    FeedBody *out = (FeedBody *)(frame + 1);
+    for (int i = 0; i < count; i++) {
+        int slot = bodies.slot[i];
+        const glm::vec3 &x = bodies.position[slot];
+        const glm::vec3 &v = bodies.velocity[slot];
+        out[i].position[0] = x.x; out[i].position[1] = x.y; out[i].position[2] = x.z;
+        out[i].velocity[0] = v.x; out[i].velocity[1] = v.y; out[i].velocity[2] = v.z;
+    }
+    frame->count = count;
+    frame->step = step;
+    frame->simTime = simTime;
+    frame->publishedNs = feedClockNs();
+
+    frame->sequence.store(sequence + 2, std::memory_order_release);
+    header->published.store(++step, std::memory_order_release);
+}
+
+// ---------------------------------------------------------------- reader
+
+SimFeedReader::SimFeedReader()
+{
+    header = NULL;
+    mappedBytes = 0;
+}
+
+SimFeedReader::~SimFeedReader()
+{
+    close();
+}
+
+#ifndef _WIN32
+
+bool SimFeedReader::open(const std::string &name)
+{
+    close();
+    int fd = shm_open(shmName(name).c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    void *memory = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size >= headerBytes) {
+        memory = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+
+    const FeedHeader *mapped = (const FeedHeader *)memory;
+    if (mapped->magic != feedMagic || mapped->version != feedVersion
+        || headerBytes + mapped->frames * mapped->frameBytes > (size_t)info.st_size) {
+        munmap(memory, info.st_size);
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    header = mapped;
+    mappedBytes = info.st_size;
+    return true;
+}
+
+void SimFeedReader::close()
+{
+    if (!header) {
+        return;
+    }
+    munmap((void *)header, mappedBytes);
+    header = NULL;
+}
+
+#else
+
+bool SimFeedReader::open(const std::string &name)
+{
+    return false;
+}
+
+void SimFeedReader::close()
+{
+}
+
+#endif
+
+uint64_t SimFeedReader::published() const
+{
+    return header ? header->published.load(std::memory_order_acquire) : 0;
+}
+
+const FeedFrame *SimFeedReader::beginRead(uint32_t &sequence) const
+{
+    uint64_t newest = published();
+    if (newest == 0) {
+        return NULL;
+    }
+    const FeedFrame *frame = frameAt(header, newest - 1);
+    sequence = frame->sequence.load(std::memory_order_acquire);
+    return frame;
+}
+
+bool SimFeedReader::endRead(const FeedFrame *frame, uint32_t sequence) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (sequence & 1) == 0 && frame->sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+// a writer that died or stalled inside a frame leaves its sequence odd for good
+static const int maxReadAttempts = 64;
+
+static inline void readBackoff()
+{
+#ifndef _WIN32
+    sched_yield();
+#endif
+}
+
+bool SimFeedReader::readLatest(FeedSnapshot &snapshot, int *retries) const
+{
+    for (int attempt = 0; attempt < maxReadAttempts; attempt++) {
+        if (retries) {
+            *retries = attempt;
+        }
+        if (attempt > 0) {
+            readBackoff();
+        }
+        uint32_t sequence;
+        const FeedFrame *frame = beginRead(sequence);
+        if (!frame) {
+            return false;
+        }
+        if (sequence & 1) {
+            continue;   // writer is inside this frame right now
+        }
+        uint32_t count = std::min(frame->count, header->maxBodies);
+        snapshot.step = frame->step;
+        snapshot.simTime = frame->simTime;
+        snapshot.publishedNs = frame->publishedNs;
+        snapshot.bodies.resize(count);
+        memcpy(snapshot.bodies.data(), bodiesOf(frame), count * sizeof(FeedBody));
+        if (endRead(frame, sequence)) {
+            return true;
+        }
+    }
+    return false;
+}
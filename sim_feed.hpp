@@ -0,0 +1,102 @@
+#ifndef SIM_FEED_H
+#define SIM_FEED_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "world.hpp"
+
+/*
+ Body state published every step into a POSIX shared-memory object (/dev/shm/<name>) so other
+ processes can follow the simulation without touching it. The object is a header followed by a
+ ring of frames; the writer fills the next frame and never waits for readers. Each frame is
+ guarded by a seqlock: odd sequence while it is being written, so a reader copies or reads the
+ frame in place and retries if the sequence changed underneath it.
+
+ Bodies are written in id order (the order add() handed them out), not storage order, so
+ readers see the same body at the same index from step to step.
+*/
+
+struct FeedBody
+{
+    float position[3];
+    float velocity[3];
+};
+
+struct FeedFrame
+{
+    std::atomic<uint32_t> sequence;     // odd while the writer is inside
+    uint32_t count;
+    uint64_t step;
+    double simTime;
+    int64_t publishedNs;                // steady clock (CLOCK_MONOTONIC), comparable across processes
+    // FeedBody bodies[maxBodies] follows
+};
+
+struct FeedHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t frames;
+    uint32_t maxBodies;
+    uint64_t frameBytes;
+    std::atomic<uint64_t> published;    // steps published so far, the newest is in frame (published - 1) % frames
+    int32_t writerPid;                  // process that owns the object, to tell a live feed from a stale one
+};
+
+// a frame copied out of the feed
+struct FeedSnapshot
+{
+    uint64_t step;
+    double simTime;
+    int64_t publishedNs;
+    std::vector<FeedBody> bodies;
+};
+
+int64_t feedClockNs();
+
+class SimFeedWriter
+{
+public:
+    SimFeedWriter();
+    ~SimFeedWriter();
+    bool open(const std::string &name, int maxBodies, int frames = 4);
+    void close();
+    void publish(const Bodies &bodies, double simTime);
+    bool isOpen() const { return header != NULL; }
+
+private:
+    std::string name;
+    FeedHeader *header;
+    size_t mappedBytes;
+    uint64_t step;
+};
+
+class SimFeedReader
+{
+public:
+    SimFeedReader();
+    ~SimFeedReader();
+    bool open(const std::string &name);
+    void close();
+    uint64_t published() const;         // 0 until the first step arrives
+
+    // zero-copy read of the newest frame: look at frame/bodies between beginRead and endRead,
+    // and only trust what you saw if endRead returns true
+    const FeedFrame *beginRead(uint32_t &sequence) const;
+    bool endRead(const FeedFrame *frame, uint32_t sequence) const;
+    static const FeedBody *bodiesOf(const FeedFrame *frame) { return (const FeedBody *)(frame + 1); }
+
+    // copy of the newest frame, retried (with a yield) until consistent. False if nothing is
+    // published yet, or after 64 attempts, e.g. when the writer died inside a frame.
+    bool readLatest(FeedSnapshot &snapshot, int *retries = NULL) const;
+
+private:
+    const FeedHeader *header;
+    size_t mappedBytes;
+};
+
+#endif // SIM_FEED_H
@@ -0,0 +1,371 @@
+#include "spatial.hpp"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdlib>
+
+// below this a single thread sorts faster than waking workers
+static const size_t parallelSortThreshold = 1 << 16;
+static const int maxThreads = 8;
+
+// threads started once and parked between jobs; starting threads per sort would allocate
+// (and cost more than the sort) every step
+class WorkerPool
+{
+public:
+    typedef void (*Job)(const void *context, int t);
+
+    WorkerPool()
+    {
+        generation = 0;
+        pending = 0;
+        stopping = false;
+        int workers = std::max(1, std::min(maxThreads, (int)std::thread::hardware_concurrency())) - 1;
+        for (int i = 0; i < workers; i++) {
+            threads.emplace_back(&WorkerPool::work, this, i);
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        start.notify_all();
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+
+    int size() const { return (int)threads.size() + 1; }
+
+    // job(context, t) for t in [0, count), the last one on the calling thread
+    void run(int count, Job job, const void *context)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->job = job;
+            this->context = context;
+            jobThreads = count;
+            pending = count - 1;
+            generation++;
+        }
+        start.notify_all();
+        job(context, count - 1);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+    }
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable start, done;
+    uint64_t generation;
+    int pending, jobThreads;
+    bool stopping;
+    Job job;
+    const void *context;
+
+    void work(int index)
+    {
+        uint64_t seen = 0;
+        for (;;) {
+            std::unique_lock<std::mutex> lock(mutex);
+            start.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            if (index >= jobThreads - 1) {
+                continue;
+            }
+            lock.unlock();
+            job(context, index);
+            lock.lock();
+            if (--pending == 0) {
+                done.notify_one();
+            }
+        }
+    }
+};
+
+static WorkerPool &workerPool()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+// run work(t) for t in [0, threads) on the pool
+template <class Work>
+static void runParallel(int threads, const Work &work)
+{
+    if (threads == 1) {
+        work(0);
+        return;
+    }
+    workerPool().run(threads, [](const void *context, int t) { (*(const Work *)context)(t); }, &work);
+}
+
+void radixSort(ArenaVector<uint64_t> &items, ArenaVector<uint64_t> &scratch, int keyBits)
+{
+    const size_t n = items.size();
+    scratch.resize(n);
+    int threads = 1;
+    if (n >= parallelSortThreshold) {
+        threads = workerPool().size();
+    }
+    const size_t chunk = (n + threads - 1) / threads;
+
+    // each thread's digit counts live in its own arena
+    size_t *offsets[maxThreads];
+    runParallel(threads, [&](int t) {
+        offsets[t] = (size_t *)FrameArena::local().allocate(256 * sizeof(size_t), 64);
+    });
+
+    for (int shift = 32; shift < 32 + keyBits; shift += 8) {
+        // per-thread digit histograms over contiguous chunks
+        runParallel(threads, [&](int t) {
+            size_t *count = offsets[t];
+            std::fill(count, count + 256, 0);
+            size_t end = std::min(n, (t + 1) * chunk);
+            for (size_t i = t * chunk; i < end; i++) {
+                count[(items[i] >> shift) & 0xff]++;
+            }
+        });
+
+        // exclusive prefix sum, digit-major then thread, so each chunk scatters stably
+        size_t sum = 0;
+        bool allSame = false;
+        for (int digit = 0; digit < 256; digit++) {
+            size_t digitTotal = 0;
+            for (int t = 0; t < threads; t++) {
+                size_t count = offsets[t][digit];
+                offsets[t][digit] = sum;
+                sum += count;
+                digitTotal += count;
+            }
+            allSame = allSame || digitTotal == n;
+        }
+        if (allSame) {
+            continue;   // every item has the same digit here, the pass wouldn't move anything
+        }
+
+        runParallel(threads, [&](int t) {
+            size_t *offset = offsets[t];
+            size_t end = std::min(n, (t + 1) * chunk);
+            for (size_t i = t * chunk; i < end; i++) {
+                scratch[offset[(items[i] >> shift) & 0xff]++] = items[i];
+            }
+        });
+        items.swap(scratch);
+    }
+}
+
+// ---------------------------------------------------------------- broad phase
+
+// Fibonacci hashing: the top bits of the product depend on every bit of the code, the low
+// bits only on the low bits, so the slot is taken from the top
+static inline uint32_t hashCode(uint32_t code, uint32_t shift)
+{
+    return (code * 2654435761u) >> shift;
+}
+
+BroadPhase::BroadPhase() : pairs(ArenaAllocator<std::pair<int, int>>(FrameArena::local()))
+{
+    cellSize = 2 * R;
+    table = NULL;
+    tableMask = 0;
+    tableShift = 31;
+}
+
+const BroadPhase::Cell *BroadPhase::lookup(uint32_t code) const
+{
+    for (uint32_t h = hashCode(code, tableShift); ; h = (h + 1) & tableMask) {
+        if (table[h].code == code) {
+            return &table[h];
+        }
+        if (table[h].code == UINT32_MAX) {
+            return NULL;
+        }
+    }
+}
+
+inline void BroadPhase::testPair(int i, int j, const glm::vec3 *x, float touch)
+{
+    glm::vec3 d = x[i] - x[j];
+    if (glm::dot(d, d) <= touch) {
+        pairs.push_back(i < j ? std::make_pair(i, j) : std::make_pair(j, i));
+    }
+}
+
+const PairList &BroadPhase::findPairs(const Bodies &bodies)
+{
+    const int n = bodies.size();
+    const glm::vec3 *x = bodies.position.data();
+    // last step's storage may be gone with the arena reset, start from fresh arena memory
+    // sized for about as many pairs as last time
+    size_t expected = pairs.size() + pairs.size() / 4 + 16;
+    pairs = arenaVector<std::pair<int, int>>(expected);
+    if (n < 2) {
+        return pairs;
+    }
+
+    glm::vec3 lo = x[0];
+    for (int i = 1; i < n; i++) {
+        lo = glm::min(lo, x[i]);
+    }
+
+    // cell of every body, sorted by Morton code; cells past 1023 along an axis are clamped
+    // together, which only adds candidates
+    ArenaVector<uint64_t> keys = arenaVector<uint64_t>(n), scratch = arenaVector<uint64_t>(n);
+    ArenaVector<glm::ivec3> cellOf = arenaVector<glm::ivec3>(n);
+    keys.resize(n);
+    cellOf.resize(n);
+    for (int i = 0; i < n; i++) {
+        glm::vec3 c = (x[i] - lo) / cellSize;
+        glm::ivec3 cell(std::min((int)c.x, 1023), std::min((int)c.y, 1023), std::min((int)c.z, 1023));
+        cellOf[i] = cell;
+        keys[i] = ((uint64_t)mortonCode(cell.x, cell.y, cell.z) << 32) | (uint32_t)i;
+    }
+    radixSort(keys, scratch, 30);
+
+    // hash table of occupied cells -> their range in keys
+    size_t tableSize = 2;
+    uint32_t tableBits = 1;
+    while (tableSize < 2 * (size_t)n) {
+        tableSize <<= 1;
+        tableBits++;
+    }
+    Cell empty = {UINT32_MAX, 0, 0};
+    ArenaVector<Cell> cells = arenaVector<Cell>(tableSize);
+    cells.assign(tableSize, empty);
+    table = cells.data();
+    tableMask = tableSize - 1;
+    tableShift = 32 - tableBits;
+    const uint32_t mask = tableMask;
+    for (int k = 0; k < n; ) {
+        uint32_t code = keys[k] >> 32;
+        int end = k + 1;
+        while (end < n && (uint32_t)(keys[end] >> 32) == code) {
+            end++;
+        }
+        uint32_t h = hashCode(code, tableShift);
+        while (cells[h].code != UINT32_MAX) {
+            h = (h + 1) & mask;
+        }
+        cells[h].code = code;
+        cells[h].start = k;
+        cells[h].end = end;
+        k = end;
+    }
+
+    // each occupied cell against itself and the 13 neighbours that come after it, so every
+    // pair of cells is visited once
+    static const int forward[13][3] = {
+        {1, 0, 0}, {-1, 1, 0}, {0, 1, 0}, {1, 1, 0},
+        {-1, -1, 1}, {0, -1, 1}, {1, -1, 1}, {-1, 0, 1}, {0, 0, 1}, {1, 0, 1}, {-1, 1, 1}, {0, 1, 1}, {1, 1, 1}
+    };
+    const float touch = 2 * R * 2 * R;
+    for (int k = 0; k < n; ) {
+        const Cell *cell = lookup(keys[k] >> 32);
+        glm::ivec3 c = cellOf[(int)(keys[k] & 0xffffffff)];
+        for (uint32_t p = cell->start; p < cell->end; p++) {
+            for (uint32_t q = p + 1; q < cell->end; q++) {
+                testPair((int)(keys[p] & 0xffffffff), (int)(keys[q] & 0xffffffff), x, touch);
+            }
+        }
+        for (int f = 0; f < 13; f++) {
+            int cx = c.x + forward[f][0], cy = c.y + forward[f][1], cz = c.z + forward[f][2];
+            if (cx < 0 || cy < 0 || cz < 0 || cx > 1023 || cy > 1023 || cz > 1023) {
+                continue;
+            }
+            const Cell *neighbour = lookup(mortonCode(cx, cy, cz));
+            if (!neighbour) {
+                continue;
+            }
+            for (uint32_t p = cell->start; p < cell->end; p++) {
+                for (uint32_t q = neighbour->start; q < neighbour->end; q++) {
+                    testPair((int)(keys[p] & 0xffffffff), (int)(keys[q] & 0xffffffff), x, touch);
+                }
+            }
+        }
+        k = cell->end;
+    }
+    return pairs;
+}
+
+void BroadPhase::collide(Bodies &bodies)
+{
+    findPairs(bodies);
+    for (const std::pair<int, int> &pair : pairs) {
+        int i = pair.first, j = pair.second;
+        SphereContactFriction(bodies.position[i], bodies.velocity[i], bodies.angularVelocity[i], bodies.mass[i],
+            bodies.position[j], bodies.velocity[j], bodies.angularVelocity[j], bodies.mass[j]);
+    }
+}
+
+// ---------------------------------------------------------------- reorder
+
+BodyReorder::BodyReorder()
+{
+    interval = 32;
+    stepsSinceSort = 0;
+}
+
+bool BodyReorder::update(Bodies &bodies)
+{
+    if (++stepsSinceSort < interval) {
+        return false;
+    }
+    reorder(bodies);
+    return true;
+}
+
+void BodyReorder::reorder(Bodies &bodies)
+{
+    const int n = bodies.size();
+    stepsSinceSort = 0;
+    if (n < 2) {
+        return;
+    }
+
+    const glm::vec3 *x = bodies.position.data();
+    glm::vec3 lo = x[0], hi = x[0];
+    for (int i = 1; i < n; i++) {
+        lo = glm::min(lo, x[i]);
+        hi = glm::max(hi, x[i]);
+    }
+    glm::vec3 extent = glm::max(hi - lo, glm::vec3(1e-6f));
+    glm::vec3 scale = glm::vec3(1023.0f) / extent;
+
+    ArenaVector<uint64_t> keys = arenaVector<uint64_t>(n), scratch = arenaVector<uint64_t>(n);
+    keys.resize(n);
+    for (int i = 0; i < n; i++) {
+        glm::vec3 q = (x[i] - lo) * scale;
+        keys[i] = ((uint64_t)mortonCode((uint32_t)q.x, (uint32_t)q.y, (uint32_t)q.z) << 32) | (uint32_t)i;
+    }
+    radixSort(keys, scratch, 30);
+
+    // how far did the order drift since the last sort? shifting by a few slots is harmless,
+    // bodies that jump further are the ones that cost cache misses
+    int displaced = 0;
+    ArenaVector<int> order = arenaVector<int>(n);
+    order.resize(n);
+    for (int i = 0; i < n; i++) {
+        order[i] = (int)(keys[i] & 0xffffffff);
+        if (std::abs(order[i] - i) > 16) {
+            displaced++;
+        }
+    }
+    bodies.permute(order.data());
+
+    float displacedFraction = (float)displaced / n;
+    if (displacedFraction > 0.25f) {
+        interval = std::max(minInterval, interval / 2);
+    } else if (displacedFraction < 0.05f) {
+        interval = std::min(maxInterval, interval * 2);
+    }
+}
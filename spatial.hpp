@@ -0,0 +1,76 @@
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "world.hpp"
+#include "frame_arena.hpp"
+
+// 10 bits per axis interleaved into a 30-bit Morton (Z-order) code
+inline uint32_t spreadBits(uint32_t v)
+{
+    v &= 0x3ff;
+    v = (v | (v << 16)) & 0x030000ff;
+    v = (v | (v << 8)) & 0x0300f00f;
+    v = (v | (v << 4)) & 0x030c30c3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+inline uint32_t mortonCode(uint32_t x, uint32_t y, uint32_t z)
+{
+    return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+}
+
+// LSD radix sort of items packed as (key << 32 | payload), on the low keyBits of the key.
+// Big inputs are histogrammed and scattered by several threads; the sort is stable.
+// scratch must come from the same arena as items.
+void radixSort(ArenaVector<uint64_t> &items, ArenaVector<uint64_t> &scratch, int keyBits);
+
+typedef ArenaVector<std::pair<int, int>> PairList;
+
+// uniform grid broad phase with cells of one sphere diameter. Bodies are sorted by the
+// Morton code of their cell, so a cell's bodies are contiguous and neighbouring cells mostly
+// are too; every step finds the touching pairs and resolves them with SphereContact.
+// Working memory comes from the frame arena, so the pairs are valid until the next reset.
+class BroadPhase
+{
+public:
+    BroadPhase();
+    void collide(Bodies &bodies);
+    const PairList &findPairs(const Bodies &bodies);
+
+private:
+    struct Cell {
+        uint32_t code, start, end;  // range in the sorted keys
+    };
+
+    float cellSize;
+    const Cell *table;              // open addressing on code, size a power of two
+    uint32_t tableMask;
+    uint32_t tableShift;            // 32 - log2(table size), the hash keeps the top bits
+    PairList pairs;
+
+    const Cell *lookup(uint32_t code) const;
+    void testPair(int i, int j, const glm::vec3 *x, float touch);
+};
+
+// sorts the body arrays by the Morton code of their position every K steps so bodies close
+// in space are close in memory. K adapts: halved when the last sort moved many bodies far,
+// doubled when it barely changed anything. Body ids stay valid through Bodies::slot.
+class BodyReorder
+{
+public:
+    BodyReorder();
+    bool update(Bodies &bodies);    // call once per step, true if it reordered
+    void reorder(Bodies &bodies);
+    int getInterval() const { return interval; }
+
+private:
+    static const int minInterval = 4;
+    static const int maxInterval = 512;
+    int interval, stepsSinceSort;
+};
+
+#endif // SPATIAL_H
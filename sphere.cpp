@@ -23,13 +23,15 @@ Sphere::~Sphere()
 
 }
 
-void Sphere::init(GLuint vertexPositionID, float radius)
+void Sphere::init(const VertexLayout &layout, float radius)
 {
-    std::vector<GLfloat> vertices;
-    std::vector<GLuint> indices;
-    std::vector<GLuint> lineIndices;
-    std::vector<GLuint> normals;
-    std::vector<GLuint> texCoords;
+    // built in the frame arena, sized up front so nothing is regrown
+    const int vertexCount = (stackCount + 1) * (sectorCount + 1);
+    ArenaVector<GLfloat> vertices = arenaVector<GLfloat>(3 * vertexCount);
+    ArenaVector<GLuint> indices = arenaVector<GLuint>(6 * stackCount * sectorCount);
+    ArenaVector<GLuint> lineIndices = arenaVector<GLuint>(4 * stackCount * sectorCount);
+    ArenaVector<GLfloat> normals = arenaVector<GLfloat>(3 * vertexCount);
+    ArenaVector<GLfloat> texCoords = arenaVector<GLfloat>(2 * vertexCount);
     float x, y, z, xy;                              // vertex position
     float nx, ny, nz, lengthInv = 1.0f / radius;    // vertex normal
     float s, t;                                     // vertex texCoord
@@ -109,34 +111,31 @@ void Sphere::init(GLuint vertexPositionID, float radius)
             }
         }
     }
+    // 8-byte quantized vertices, triangles reordered for the vertex cache
+    ArenaVector<PackedVertex> packed = arenaVector<PackedVertex>(vertexCount);
+    bounds = packVertices(vertices, normals, packed);
+    float missRatio = cacheMissRatio(indices);
+    optimizeVertexCache(indices, packed.size());
+    this->layout = layout;
+
     glGenVertexArrays(1, &sphere_vao);
     glBindVertexArray(sphere_vao);
-
-    glGenBuffers(1, &sphere_vboVertex);
-    glBindBuffer(GL_ARRAY_BUFFER, sphere_vboVertex);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), &vertices[0], GL_STATIC_DRAW);
-
-    glVertexAttribPointer(vertexPositionID, 3, GL_FLOAT, GL_FALSE, 0, NULL);
-    glEnableVertexAttribArray (vertexPositionID);
-
-    glGenBuffers(1, &sphere_vboIndex);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphere_vboIndex);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
-
+    indexType = uploadMesh(layout, packed, indices, sphere_vboVertex, sphere_vboIndex);
     glBindVertexArray(0);
 
     numsToDraw = indices.size();
 
     std::ofstream sphere_vertex_log_file;
     sphere_vertex_log_file.open("sphere_v.log");
-	for (int k = 0;k<=vertices.size();k++){
+    sphere_vertex_log_file << meshStats(packed.size(), indices, missRatio) << std::endl;
+	for (int k = 0;k<vertices.size();k++){
         sphere_vertex_log_file << " Vertices[" << k << "]: " << vertices[k] << std::endl;
     }
     sphere_vertex_log_file.close();
 
     std::ofstream sphere_index_log_file;
     sphere_index_log_file.open("sphere_i.log");
-	for (int k = 0;k<=indices.size();k++){ 
+	for (int k = 0;k<indices.size();k++){ 
         sphere_index_log_file << " Indices[" << k << "]: " << indices[k] << std::endl;
     }
     sphere_index_log_file.close();
@@ -174,5 +173,34 @@ void Sphere::draw()
     // draw sphere
     glPolygonMode(GL_FRONT_AND_BACK,GL_LINE);
     glBindVertexArray(sphere_vao);
-    glDrawElements(GL_TRIANGLES, numsToDraw, GL_UNSIGNED_INT, NULL);
-}
\ No newline at end of file
+    setMeshBounds(layout, bounds);
+    glDrawElements(GL_TRIANGLES, numsToDraw, indexType, NULL);
+}
+
+void Sphere::setInstances(GLuint buffer, const GLint rows[3])
+{
+    glBindVertexArray(sphere_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (int row = 0; row < 3; row++) {
+        if (rows[row] < 0) {
+            continue;
+        }
+        glEnableVertexAttribArray(rows[row]);
+        glVertexAttribPointer(rows[row], 4, GL_FLOAT, GL_FALSE, 12 * sizeof(GLfloat), (const GLvoid *)(row * 4 * sizeof(GLfloat)));
+        glVertexAttribDivisor(rows[row], 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void Sphere::drawInstanced(int count)
+{
+    if (!isInited) {
+        std::cout << "please call init() before drawInstanced()" << std::endl;
+    }
+
+    glPolygonMode(GL_FRONT_AND_BACK,GL_LINE);
+    glBindVertexArray(sphere_vao);
+    setMeshBounds(layout, bounds);
+    glDrawElementsInstanced(GL_TRIANGLES, numsToDraw, indexType, NULL, count);
+}
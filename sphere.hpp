@@ -3,15 +3,19 @@
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
+#include "mesh_pack.hpp"
 
 class Sphere
 {
 public:
     Sphere();
     ~Sphere();
-    void init(GLuint vertexPositionID, float radius);
+    void init(const VertexLayout &layout, float radius);
     void cleanup();
     void draw();
+    // per-instance 3x4 transforms from buffer, one vec4 row per attribute in rows[0..2]
+    void setInstances(GLuint buffer, const GLint rows[3]);
+    void drawInstanced(int count);
     glm::vec3 getPosition() const { return position; }
 	glm::vec3 getVelocity() const { return velocity; }
 	glm::vec3 getAcceleration() const { return acceleration; }
@@ -28,6 +32,9 @@ private:
     bool isInited;
     GLuint sphere_vao, sphere_vboVertex, sphere_vboIndex;
     int numsToDraw;
+    GLenum indexType;
+    VertexLayout layout;
+    MeshBounds bounds;
     glm::vec3 position;
     glm::vec3 velocity;
     glm::vec3 acceleration;
@@ -0,0 +1,108 @@
+#include "world.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include "frame_arena.hpp"
+
+int Bodies::add(const glm::vec3 &x, const glm::vec3 &v, float m)
+{
+    position.push_back(x);
+    velocity.push_back(v);
+    acceleration.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
+    mass.push_back(m);
+    orientation.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    angularVelocity.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
+    id.push_back(size() - 1);
+    slot.push_back(size() - 1);
+    return size() - 1;
+}
+
+// gathered into frame arena scratch and copied back, so reordering doesn't touch the heap
+template <class T>
+static void permuteArray(std::vector<T> &values, const int *order)
+{
+    T *permuted = (T *)FrameArena::local().allocate(values.size() * sizeof(T), alignof(T));
+    for (size_t i = 0; i < values.size(); i++) {
+        permuted[i] = values[order[i]];
+    }
+    std::copy(permuted, permuted + values.size(), values.begin());
+}
+
+void Bodies::permute(const int *order)
+{
+    permuteArray(position, order);
+    permuteArray(velocity, order);
+    permuteArray(acceleration, order);
+    permuteArray(mass, order);
+    permuteArray(orientation, order);
+    permuteArray(angularVelocity, order);
+    permuteArray(id, order);
+    for (int i = 0; i < size(); i++) {
+        slot[id[i]] = i;
+    }
+}
+
+template <class Integrator, class Force, class Boundary>
+static Stepper stepperFor()
+{
+    Stepper stepper = {&World<Integrator, Force, Boundary>::prime, &World<Integrator, Force, Boundary>::step};
+    return stepper;
+}
+
+template <class Integrator, class Force>
+static void fillBoundaries(Stepper *row)
+{
+    row[BOUNDARY_BOX] = stepperFor<Integrator, Force, BoxBoundary>();
+    row[BOUNDARY_NONE] = stepperFor<Integrator, Force, NoBoundary>();
+}
+
+template <class Integrator>
+static void fillForces(Stepper (*rows)[NUM_BOUNDARIES])
+{
+    fillBoundaries<Integrator, UniformGravity>(rows[FORCE_GRAVITY]);
+    fillBoundaries<Integrator, NoForce>(rows[FORCE_NONE]);
+}
+
+// every combination instantiated up front, indexed [integrator][force][boundary]
+struct StepperTable
+{
+    Stepper entries[NUM_INTEGRATORS][NUM_FORCES][NUM_BOUNDARIES];
+
+    StepperTable()
+    {
+        fillForces<Euler>(entries[INTEGRATOR_EULER]);
+        fillForces<RK4>(entries[INTEGRATOR_RK4]);
+        fillForces<Verlet>(entries[INTEGRATOR_VERLET]);
+    }
+};
+
+Stepper selectStepper(IntegratorKind integrator, ForceKind force, BoundaryKind boundary)
+{
+    static const StepperTable table;
+    return table.entries[integrator][force][boundary];
+}
+
+bool parseIntegrator(const char *name, IntegratorKind &integrator)
+{
+    if (strcmp(name, "euler") == 0) {
+        integrator = INTEGRATOR_EULER;
+    } else if (strcmp(name, "rk4") == 0) {
+        integrator = INTEGRATOR_RK4;
+    } else if (strcmp(name, "verlet") == 0) {
+        integrator = INTEGRATOR_VERLET;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void collideBodies(Bodies &bodies)
+{
+    const int n = bodies.size();
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            SphereContactFriction(bodies.position[i], bodies.velocity[i], bodies.angularVelocity[i], bodies.mass[i],
+                bodies.position[j], bodies.velocity[j], bodies.angularVelocity[j], bodies.mass[j]);
+        }
+    }
+}
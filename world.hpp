@@ -0,0 +1,162 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "physics.hpp"
+#include "orientation.hpp"
+
+/*
+ World<Integrator, Force, Boundary>::step runs one fused loop over all bodies with every
+ policy inlined, so the inner loop has no calls through pointers and no branches on
+ configuration. Pick a combination once with selectStepper() and keep the function pointers.
+ Orientations advance in the same step, in a batch pass after the positions.
+
+ The policies match IntegrateEuler/IntegrateRK4/IntegrateVerlet, updateAcceleration and CheckBC.
+*/
+
+// body state, one array per field. The arrays may be reordered (see BodyReorder), so a body
+// is identified by the id add() returned and found through slot[id].
+struct Bodies
+{
+    std::vector<glm::vec3> position;
+    std::vector<glm::vec3> velocity;
+    std::vector<glm::vec3> acceleration;
+    std::vector<float> mass;
+    std::vector<glm::quat> orientation;
+    std::vector<glm::vec3> angularVelocity;   // world frame, rad/s
+    std::vector<int> id;    // id of the body stored in each slot
+    std::vector<int> slot;  // slot holding each id
+
+    int add(const glm::vec3 &x, const glm::vec3 &v, float m);
+    int size() const { return (int)mass.size(); }
+    void permute(const int *order);  // new slot i takes the body from slot order[i]
+};
+
+// ---------------------------------------------------------------- force policies
+
+struct UniformGravity
+{
+    static inline glm::vec3 acceleration(const glm::vec3 &x, float m) { return glm::vec3(0.0f, 0.0f, -gravity); }
+};
+
+struct NoForce
+{
+    static inline glm::vec3 acceleration(const glm::vec3 &x, float m) { return glm::vec3(0.0f, 0.0f, 0.0f); }
+};
+
+// ---------------------------------------------------------------- integrator policies
+
+struct Euler
+{
+    template <class Force>
+    static inline void step(glm::vec3 &x, glm::vec3 &v, glm::vec3 &a, float m, float DT)
+    {
+        v += a*DT;
+        x += v*DT;
+        a = Force::acceleration(x, m);
+    }
+};
+
+struct RK4
+{
+    template <class Force>
+    static inline void step(glm::vec3 &x, glm::vec3 &v, glm::vec3 &a, float m, float DT)
+    {
+        glm::vec3 Kv1 = a;
+        glm::vec3 Kx1 = v;
+        glm::vec3 Kv2 = Force::acceleration(x + Kx1*DT/2.0f, m);
+        glm::vec3 Kx2 = v + Kv1*DT/2.0f;
+        glm::vec3 Kv3 = Force::acceleration(x + Kx2*DT/2.0f, m);
+        glm::vec3 Kx3 = v + Kv2*DT/2.0f;
+        glm::vec3 Kv4 = Force::acceleration(x + Kx3*DT, m);
+        glm::vec3 Kx4 = v + Kv3*DT;
+
+        v += (Kv1 + Kv2*2.0f + Kv3*2.0f + Kv4)/6.0f*DT;
+        x += (Kx1 + Kx2*2.0f + Kx3*2.0f + Kx4)/6.0f*DT;
+        a = Force::acceleration(x, m);
+    }
+};
+
+struct Verlet
+{
+    template <class Force>
+    static inline void step(glm::vec3 &x, glm::vec3 &v, glm::vec3 &a, float m, float DT)
+    {
+        x = x + v*DT + 1.0f/2.0f*a*DT*DT;
+        glm::vec3 oldAcceleration = a;
+        a = Force::acceleration(x, m);
+        v += 1.0f/2.0f*(oldAcceleration*DT + a*DT);
+    }
+};
+
+// ---------------------------------------------------------------- boundary policies
+
+// the 4x4 box standing on the z=0 plane, same as CheckBC
+struct BoxBoundary
+{
+    static inline void apply(glm::vec3 &x, glm::vec3 &v)
+    {
+        if (x.z <= R) { v.z = -v.z; x.z = R; }
+        if (x.x <= -2+R) { v.x = -v.x; x.x = -2+R; }
+        if (x.x >= 2-R) { v.x = -v.x; x.x = 2-R; }
+        if (x.y <= -2+R) { v.y = -v.y; x.y = -2+R; }
+        if (x.y >= 2-R) { v.y = -v.y; x.y = 2-R; }
+    }
+};
+
+struct NoBoundary
+{
+    static inline void apply(glm::vec3 &x, glm::vec3 &v) {}
+};
+
+// ---------------------------------------------------------------- stepper
+
+template <class Integrator, class Force, class Boundary>
+struct World
+{
+    // acceleration at the current positions, once before the first step
+    static void prime(Bodies &bodies)
+    {
+        const int n = bodies.size();
+        const glm::vec3 *x = bodies.position.data();
+        glm::vec3 *a = bodies.acceleration.data();
+        const float *m = bodies.mass.data();
+        for (int i = 0; i < n; i++) {
+            a[i] = Force::acceleration(x[i], m[i]);
+        }
+    }
+
+    static void step(Bodies &bodies, float DT)
+    {
+        const int n = bodies.size();
+        glm::vec3 *x = bodies.position.data();
+        glm::vec3 *v = bodies.velocity.data();
+        glm::vec3 *a = bodies.acceleration.data();
+        const float *m = bodies.mass.data();
+        for (int i = 0; i < n; i++) {
+            Integrator::template step<Force>(x[i], v[i], a[i], m[i], DT);
+            Boundary::apply(x[i], v[i]);
+        }
+        integrateOrientations(bodies, DT);
+    }
+};
+
+enum IntegratorKind { INTEGRATOR_EULER, INTEGRATOR_RK4, INTEGRATOR_VERLET, NUM_INTEGRATORS };
+enum ForceKind { FORCE_GRAVITY, FORCE_NONE, NUM_FORCES };
+enum BoundaryKind { BOUNDARY_BOX, BOUNDARY_NONE, NUM_BOUNDARIES };
+
+struct Stepper
+{
+    void (*prime)(Bodies &bodies);
+    void (*step)(Bodies &bodies, float DT);
+};
+
+Stepper selectStepper(IntegratorKind integrator, ForceKind force, BoundaryKind boundary);
+bool parseIntegrator(const char *name, IntegratorKind &integrator);  // "euler", "rk4" or "verlet"
+
+// all-pairs SphereContact over the bodies
+void collideBodies(Bodies &bodies);
+
+#endif // WORLD_H